@@ -0,0 +1,120 @@
+#include "bench.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+	void print_usage(const char* program) {
+		std::cout << "usage: " << program << " [--filter <substring>] [--samples <count>] [--min-time <milliseconds>] [--output <file.json>]" << std::endl;
+	}
+
+	std::string json_escape(const std::string& s) {
+		std::string escaped;
+		escaped.reserve(s.size());
+		for (char c : s) {
+			switch (c) {
+			case '"':
+				escaped += "\\\"";
+				break;
+			case '\\':
+				escaped += "\\\\";
+				break;
+			case '\n':
+				escaped += "\\n";
+				break;
+			default:
+				escaped += c;
+				break;
+			}
+		}
+		return escaped;
+	}
+
+	void write_json(std::ostream& out, const bench::options& opts, const std::vector<bench::result>& results) {
+		out << "{\n";
+		out << "\t\"lua\": \"" << json_escape(LUA_VERSION) << "\",\n";
+		out << "\t\"samples\": " << opts.samples << ",\n";
+		out << "\t\"results\": [";
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			const bench::result& r = results[i];
+			out << (i == 0 ? "\n" : ",\n");
+			out << "\t\t{ \"category\": \"" << json_escape(r.category) << "\""
+				<< ", \"implementation\": \"" << json_escape(r.implementation) << "\""
+				<< ", \"ns_per_op\": " << r.ns_per_op
+				<< ", \"ns_per_op_min\": " << r.ns_per_op_min
+				<< ", \"iterations\": " << r.iterations;
+			if (!r.counters.empty()) {
+				out << ", \"counters\": {";
+				for (std::size_t c = 0; c < r.counters.size(); ++c) {
+					out << (c == 0 ? " " : ", ") << "\"" << json_escape(r.counters[c].first) << "\": " << r.counters[c].second;
+				}
+				out << " }";
+			}
+			out << " }";
+		}
+		out << "\n\t]\n";
+		out << "}\n";
+	}
+}
+
+int main(int argc, char* argv[]) {
+	bench::options opts;
+	std::string output;
+	for (int i = 1; i < argc; ++i) {
+		const char* arg = argv[i];
+		bool hasvalue = i + 1 < argc;
+		if (std::strcmp(arg, "--filter") == 0 && hasvalue) {
+			opts.filter = argv[++i];
+		}
+		else if (std::strcmp(arg, "--samples") == 0 && hasvalue) {
+			opts.samples = static_cast<std::size_t>((std::max)(1, std::atoi(argv[++i])));
+		}
+		else if (std::strcmp(arg, "--min-time") == 0 && hasvalue) {
+			opts.min_sample_time = std::chrono::milliseconds((std::max)(1, std::atoi(argv[++i])));
+		}
+		else if (std::strcmp(arg, "--output") == 0 && hasvalue) {
+			output = argv[++i];
+		}
+		else {
+			print_usage(argv[0]);
+			return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	std::vector<bench::result> results;
+	std::cout << std::left << std::setw(48) << "category" << std::setw(14) << "implementation" << std::right << std::setw(14) << "ns/op" << std::endl;
+	for (const bench::case_entry& entry : bench::registry()) {
+		std::string fullname = entry.category + "/" + entry.implementation;
+		if (!opts.filter.empty() && fullname.find(opts.filter) == std::string::npos) {
+			continue;
+		}
+		bench::meter m(opts);
+		try {
+			entry.fx(m);
+		}
+		catch (const std::exception& e) {
+			std::cerr << fullname << " failed: " << e.what() << std::endl;
+			return 1;
+		}
+		results.push_back(bench::result{ entry.category, entry.implementation, m.median(), m.minimum(), m.iterations(), m.counters() });
+		std::cout << std::left << std::setw(48) << entry.category << std::setw(14) << entry.implementation
+			<< std::right << std::setw(14) << std::fixed << std::setprecision(2) << m.median();
+		for (const auto& c : m.counters()) {
+			std::cout << "  " << c.first << "=" << c.second;
+		}
+		std::cout << std::endl;
+	}
+
+	if (!output.empty()) {
+		std::ofstream out(output);
+		if (!out) {
+			std::cerr << "unable to open " << output << " for writing" << std::endl;
+			return 1;
+		}
+		write_json(out, opts, results);
+	}
+	return 0;
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <sol.hpp>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <cstddef>
+
+namespace bench {
+
+	typedef std::chrono::high_resolution_clock clock;
+
+	struct options {
+		std::string filter;
+		std::size_t samples = 10;
+		std::chrono::nanoseconds min_sample_time = std::chrono::milliseconds(20);
+	};
+
+	// Extra per-case numbers a case wants reported next to its timing,
+	// such as bytes per operation
+	typedef std::vector<std::pair<std::string, double>> counter_list;
+
+	struct result {
+		std::string category;
+		std::string implementation;
+		double ns_per_op;
+		double ns_per_op_min;
+		std::size_t iterations;
+		counter_list counters;
+	};
+
+	// A meter times "n operations" at once: cases hand it a
+	// callable that performs exactly n operations, so that setup
+	// (state creation, script compilation, registration) stays out of the numbers
+	class meter {
+	private:
+		const options& opts;
+		std::vector<double> samples;
+		std::size_t batch;
+		counter_list reported;
+
+		template <typename Fx>
+		double time_batch(Fx&& fx, std::size_t n) {
+			auto start = clock::now();
+			fx(n);
+			auto end = clock::now();
+			return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+		}
+
+		// timed(n) performs n operations and returns how many nanoseconds they took
+		template <typename Timed>
+		void sample(Timed&& timed) {
+			// grow the batch until a single sample takes long enough
+			// for the clock's resolution to not matter
+			std::size_t n = 1;
+			double min_time = static_cast<double>(opts.min_sample_time.count());
+			for (;;) {
+				double t = timed(n);
+				if (t >= min_time || n >= (std::size_t(1) << 30)) {
+					break;
+				}
+				n *= 2;
+			}
+			batch = n;
+			samples.clear();
+			samples.reserve(opts.samples);
+			for (std::size_t i = 0; i < opts.samples; ++i) {
+				samples.push_back(timed(n) / static_cast<double>(n));
+			}
+		}
+
+	public:
+		meter(const options& opts) : opts(opts), batch(0) {}
+
+		template <typename Fx>
+		void measure_batch(Fx&& fx) {
+			sample([this, &fx](std::size_t n) { return time_batch(fx, n); });
+		}
+
+		// For operations that are long enough to be timed one at a time:
+		// setup() runs untimed before every operation, its result is handed
+		// to fx, and destroying it afterwards is not timed either
+		template <typename Setup, typename Fx>
+		void measure_each(Setup&& setup, Fx&& fx) {
+			sample([&setup, &fx](std::size_t n) {
+				double total = 0;
+				for (std::size_t i = 0; i < n; ++i) {
+					auto subject = setup();
+					auto start = clock::now();
+					fx(subject);
+					auto end = clock::now();
+					total += static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+				}
+				return total;
+			});
+		}
+
+		template <typename Fx>
+		void measure(Fx&& fx) {
+			measure_batch([&fx](std::size_t n) {
+				for (std::size_t i = 0; i < n; ++i) {
+					fx();
+				}
+			});
+		}
+
+		std::size_t iterations() const {
+			return batch * samples.size();
+		}
+
+		void counter(std::string name, double value) {
+			for (auto& c : reported) {
+				if (c.first == name) {
+					c.second = value;
+					return;
+				}
+			}
+			reported.emplace_back(std::move(name), value);
+		}
+
+		const counter_list& counters() const {
+			return reported;
+		}
+
+		double median() const {
+			if (samples.empty()) {
+				return 0.0;
+			}
+			std::vector<double> sorted = samples;
+			std::sort(sorted.begin(), sorted.end());
+			return sorted[sorted.size() / 2];
+		}
+
+		double minimum() const {
+			if (samples.empty()) {
+				return 0.0;
+			}
+			return *std::min_element(samples.begin(), samples.end());
+		}
+	};
+
+	typedef std::function<void(meter&)> case_function;
+
+	struct case_entry {
+		std::string category;
+		std::string implementation;
+		case_function fx;
+	};
+
+	inline std::vector<case_entry>& registry() {
+		static std::vector<case_entry> cases;
+		return cases;
+	}
+
+	struct registrar {
+		registrar(std::string category, std::string implementation, case_function fx) {
+			registry().push_back(case_entry{ std::move(category), std::move(implementation), std::move(fx) });
+		}
+	};
+
+	inline const void* volatile& sink() {
+		static const void* volatile s = nullptr;
+		return s;
+	}
+
+	// Keeps the optimizer from throwing away results
+	template <typename T>
+	inline void do_not_optimize(T&& value) {
+		sink() = static_cast<const void*>(std::addressof(value));
+	}
+
+	// A bare lua_State for the plain C API baselines
+	struct plain_state {
+		lua_State* L;
+
+		plain_state() : L(luaL_newstate()) {
+			luaL_openlibs(L);
+		}
+
+		plain_state(const plain_state&) = delete;
+		plain_state& operator=(const plain_state&) = delete;
+
+		~plain_state() {
+			lua_close(L);
+		}
+	};
+
+	// Raw C API helper for the baselines: compiles and runs a chunk
+	inline void run_script(lua_State* L, const char* code) {
+		if (luaL_loadstring(L, code) != 0 || lua_pcall(L, 0, 0, 0) != 0) {
+			throw sol::error(lua_tostring(L, -1));
+		}
+	}
+
+	// Calls the global Lua function `name` with n, where the function
+	// is expected to run a loop of n operations inside of Lua
+	inline void run_lua_loop(lua_State* L, const char* name, std::size_t n) {
+		lua_getglobal(L, name);
+		lua_pushinteger(L, static_cast<lua_Integer>(n));
+		if (lua_pcall(L, 1, 0, 0) != 0) {
+			throw sol::error(lua_tostring(L, -1));
+		}
+	}
+
+} // bench
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+#define BENCH_CASE(category, implementation) \
+	static void BENCH_CONCAT(bench_case_, __LINE__)(bench::meter&); \
+	static bench::registrar BENCH_CONCAT(bench_registrar_, __LINE__)(category, implementation, &BENCH_CONCAT(bench_case_, __LINE__)); \
+	static void BENCH_CONCAT(bench_case_, __LINE__)(bench::meter& meter)
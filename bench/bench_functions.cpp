@@ -0,0 +1,191 @@
+#include "bench.hpp"
+
+namespace {
+	int c_function(int x) {
+		return x + 1;
+	}
+
+	int overloaded_1(int x) {
+		return x;
+	}
+
+	int overloaded_2(int x, int y) {
+		return x + y;
+	}
+
+	int overloaded_3(int x, int y, int z) {
+		return x + y + z;
+	}
+
+	const char c_function_loop[] = R"(
+function c_function_loop (n)
+	local f = f
+	local x = 0
+	for i = 1, n do
+		x = f(i)
+	end
+	return x
+end
+)";
+
+	const char overload_loop[] = R"(
+function overload_loop (n)
+	local ov = ov
+	local x = 0
+	for i = 1, n do
+		x = ov(i, i, i)
+	end
+	return x
+end
+)";
+
+	const char lua_function[] = R"(
+function lua_function (i)
+	return i
+end
+)";
+
+	int c_function_raw(lua_State* L) {
+		lua_pushinteger(L, c_function(static_cast<int>(lua_tointeger(L, 1))));
+		return 1;
+	}
+
+	int c_stateful_raw(lua_State* L) {
+		int& x = *static_cast<int*>(lua_touserdata(L, lua_upvalueindex(1)));
+		x += static_cast<int>(lua_tointeger(L, 1));
+		lua_pushinteger(L, x);
+		return 1;
+	}
+
+	int c_overloaded_raw(lua_State* L) {
+		switch (lua_gettop(L)) {
+		case 1:
+			lua_pushinteger(L, overloaded_1(static_cast<int>(lua_tointeger(L, 1))));
+			return 1;
+		case 2:
+			lua_pushinteger(L, overloaded_2(static_cast<int>(lua_tointeger(L, 1)), static_cast<int>(lua_tointeger(L, 2))));
+			return 1;
+		case 3:
+			lua_pushinteger(L, overloaded_3(static_cast<int>(lua_tointeger(L, 1)), static_cast<int>(lua_tointeger(L, 2)), static_cast<int>(lua_tointeger(L, 3))));
+			return 1;
+		default:
+			return luaL_error(L, "no matching overload");
+		}
+	}
+}
+
+BENCH_CASE("c function through lua", "sol") {
+	sol::state lua;
+	lua.set_function("f", &c_function);
+	lua.script(c_function_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "c_function_loop", n); });
+}
+
+BENCH_CASE("c function through lua", "plain_c") {
+	bench::plain_state s;
+	lua_pushcfunction(s.L, &c_function_raw);
+	lua_setglobal(s.L, "f");
+	bench::run_script(s.L, c_function_loop);
+	meter.measure_batch([&s](std::size_t n) { bench::run_lua_loop(s.L, "c_function_loop", n); });
+}
+
+BENCH_CASE("stateful c function from c++", "sol") {
+	sol::state lua;
+	int state = 0;
+	lua.set_function("stateful", [state](int x) mutable { state += x; return state; });
+	sol::function f = lua["stateful"];
+	meter.measure([&f]() {
+		int r = f(1);
+		bench::do_not_optimize(r);
+	});
+}
+
+BENCH_CASE("stateful c function from c++", "plain_c") {
+	bench::plain_state s;
+	int state = 0;
+	lua_pushlightuserdata(s.L, &state);
+	lua_pushcclosure(s.L, &c_stateful_raw, 1);
+	lua_setglobal(s.L, "stateful");
+	lua_State* L = s.L;
+	meter.measure([L]() {
+		lua_getglobal(L, "stateful");
+		lua_pushinteger(L, 1);
+		lua_call(L, 1, 1);
+		int r = static_cast<int>(lua_tointeger(L, -1));
+		lua_pop(L, 1);
+		bench::do_not_optimize(r);
+	});
+}
+
+BENCH_CASE("lua function from c++ (function)", "sol") {
+	sol::state lua;
+	lua.script(lua_function);
+	sol::function f = lua["lua_function"];
+	meter.measure([&f]() {
+		int r = f(1);
+		bench::do_not_optimize(r);
+	});
+}
+
+BENCH_CASE("lua function from c++ (function)", "plain_c") {
+	bench::plain_state s;
+	bench::run_script(s.L, lua_function);
+	lua_State* L = s.L;
+	lua_getglobal(L, "lua_function");
+	int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	meter.measure([L, ref]() {
+		lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+		lua_pushinteger(L, 1);
+		lua_call(L, 1, 1);
+		int r = static_cast<int>(lua_tointeger(L, -1));
+		lua_pop(L, 1);
+		bench::do_not_optimize(r);
+	});
+	luaL_unref(L, LUA_REGISTRYINDEX, ref);
+}
+
+BENCH_CASE("lua function from c++ (protected_function)", "sol") {
+	sol::state lua;
+	lua.script(lua_function);
+	sol::protected_function f = lua["lua_function"];
+	meter.measure([&f]() {
+		int r = f(1);
+		bench::do_not_optimize(r);
+	});
+}
+
+BENCH_CASE("lua function from c++ (protected_function)", "plain_c") {
+	bench::plain_state s;
+	bench::run_script(s.L, lua_function);
+	lua_State* L = s.L;
+	lua_getglobal(L, "lua_function");
+	int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	meter.measure([L, ref]() {
+		lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+		lua_pushinteger(L, 1);
+		if (lua_pcall(L, 1, 1, 0) != 0) {
+			throw sol::error(lua_tostring(L, -1));
+		}
+		int r = static_cast<int>(lua_tointeger(L, -1));
+		lua_pop(L, 1);
+		bench::do_not_optimize(r);
+	});
+	luaL_unref(L, LUA_REGISTRYINDEX, ref);
+}
+
+BENCH_CASE("overload resolution", "sol") {
+	sol::state lua;
+	lua.set_function("ov", sol::overload(&overloaded_1, &overloaded_2, &overloaded_3));
+	lua.script(overload_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "overload_loop", n); });
+}
+
+BENCH_CASE("overload resolution", "plain_c") {
+	bench::plain_state s;
+	lua_pushcfunction(s.L, &c_overloaded_raw);
+	lua_setglobal(s.L, "ov");
+	bench::run_script(s.L, overload_loop);
+	meter.measure_batch([&s](std::size_t n) { bench::run_lua_loop(s.L, "overload_loop", n); });
+}
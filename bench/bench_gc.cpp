@@ -0,0 +1,253 @@
+#include "bench.hpp"
+
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace {
+	// Every case builds this many objects per sample,
+	// so a full run creates and drops several million of them
+	const std::size_t gc_objects = 1000000;
+
+	// Counts gc_object destructors, so each case can report how many of
+	// its objects were really destroyed (by a __gc) while it was timed
+	std::size_t destroyed_objects = 0;
+
+	struct gc_object {
+		double values[3] = { 0, 0, 0 };
+		int id = 0;
+
+		~gc_object() {
+			++destroyed_objects;
+		}
+	};
+
+	// A stateful function: pushed as a user<gc_closure> plus a closure
+	struct gc_closure {
+		gc_object captured;
+
+		double operator()() const {
+			return captured.values[0];
+		}
+	};
+
+	typedef std::unique_ptr<sol::state> state_ptr;
+
+	void push_value(lua_State* L) {
+		sol::stack::push(L, gc_object());
+	}
+
+	void push_shared(lua_State* L) {
+		sol::stack::push(L, std::make_shared<gc_object>());
+	}
+
+	void push_closure(lua_State* L) {
+		sol::stack::push<sol::function_sig<>>(L, gc_closure());
+	}
+
+	// The hand-written equivalent: the object stored directly
+	// in the userdata, with a C finalizer (or none at all)
+	const char c_gc_metatable[] = "bench.c_gc_object";
+	const char c_nogc_metatable[] = "bench.c_nogc_object";
+
+	int c_gc_object_destroy(lua_State* L) {
+		static_cast<gc_object*>(lua_touserdata(L, 1))->~gc_object();
+		return 0;
+	}
+
+	void push_plain(lua_State* L) {
+		new (lua_newuserdata(L, sizeof(gc_object))) gc_object();
+		if (luaL_newmetatable(L, c_gc_metatable) != 0) {
+			lua_pushcfunction(L, &c_gc_object_destroy);
+			lua_setfield(L, -2, "__gc");
+		}
+		lua_setmetatable(L, -2);
+	}
+
+	void push_plain_no_finalizer(lua_State* L) {
+		new (lua_newuserdata(L, sizeof(gc_object))) gc_object();
+		luaL_newmetatable(L, c_nogc_metatable);
+		lua_setmetatable(L, -2);
+	}
+
+	// A state with the collector stopped and a table of gc_objects
+	// objects on top of the stack; drop() turns them all into garbage
+	struct garbage {
+		state_ptr lua;
+
+		garbage(void(*push)(lua_State*)) : lua(new sol::state()) {
+			lua->new_usertype<gc_object>("gc_object", "id", &gc_object::id);
+			lua_State* L = *lua;
+			lua_gc(L, LUA_GCCOLLECT, 0);
+			lua_gc(L, LUA_GCSTOP, 0);
+			lua_createtable(L, static_cast<int>(gc_objects), 0);
+			for (std::size_t i = 0; i < gc_objects; ++i) {
+				push(L);
+				lua_rawseti(L, -2, static_cast<int>(i + 1));
+			}
+		}
+
+		lua_State* state() const {
+			return *lua;
+		}
+
+		void drop() {
+			lua_settop(state(), 0);
+		}
+	};
+
+	typedef std::unique_ptr<garbage> garbage_ptr;
+
+	garbage_ptr make_dropped_garbage(void(*push)(lua_State*)) {
+		garbage_ptr g(new garbage(push));
+		g->drop();
+		return g;
+	}
+
+	void report_destroyed(bench::meter& meter, std::size_t destroyed, std::size_t runs) {
+		if (runs != 0) {
+			meter.counter("destroyed_per_op", static_cast<double>(destroyed) / static_cast<double>(runs));
+		}
+	}
+
+	void measure_full_collection(bench::meter& meter, void(*push)(lua_State*)) {
+		std::size_t destroyed = 0;
+		std::size_t runs = 0;
+		meter.measure_each([push]() { return make_dropped_garbage(push); }, [&destroyed, &runs](garbage_ptr& g) {
+			std::size_t before = destroyed_objects;
+			lua_gc(g->state(), LUA_GCCOLLECT, 0);
+			destroyed += destroyed_objects - before;
+			++runs;
+		});
+		meter.counter("ns_per_object", meter.median() / static_cast<double>(gc_objects));
+		report_destroyed(meter, destroyed, runs);
+	}
+
+	// Runs one whole collection cycle in single incremental steps (what the
+	// collector does during allocation), and reports the length of those pauses
+	void measure_incremental_steps(bench::meter& meter, void(*push)(lua_State*)) {
+		std::vector<double> pauses;
+		std::size_t cycles = 0;
+		std::size_t destroyed = 0;
+		meter.measure_each([push]() { return make_dropped_garbage(push); }, [&pauses, &cycles, &destroyed](garbage_ptr& g) {
+			lua_State* L = g->state();
+			std::size_t before = destroyed_objects;
+			for (std::size_t step = 0; step < gc_objects; ++step) {
+				auto start = bench::clock::now();
+				int finished = lua_gc(L, LUA_GCSTEP, 0);
+				auto end = bench::clock::now();
+				pauses.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+				if (finished != 0) {
+					break;
+				}
+			}
+			++cycles;
+			destroyed += destroyed_objects - before;
+		});
+		if (pauses.empty()) {
+			return;
+		}
+		std::sort(pauses.begin(), pauses.end());
+		auto percentile = [&pauses](double p) {
+			return pauses[static_cast<std::size_t>(p * static_cast<double>(pauses.size() - 1))];
+		};
+		meter.counter("step_p50_ns", percentile(0.50));
+		meter.counter("step_p99_ns", percentile(0.99));
+		meter.counter("step_p999_ns", percentile(0.999));
+		meter.counter("step_max_ns", pauses.back());
+		meter.counter("steps_per_cycle", static_cast<double>(pauses.size()) / static_cast<double>(cycles));
+		report_destroyed(meter, destroyed, cycles);
+	}
+
+	// Calls every object's __gc the way the collector would, which isolates
+	// call_detail::destruct, detail::unique_destruct and friends from the
+	// marking and sweeping around them. The metatable is taken off afterwards
+	// so the objects are not finalized a second time when the state closes
+	void measure_finalizers(bench::meter& meter, void(*push)(lua_State*)) {
+		std::size_t destroyed = 0;
+		std::size_t runs = 0;
+		meter.measure_each([push]() { return garbage_ptr(new garbage(push)); }, [&destroyed, &runs](garbage_ptr& g) {
+			lua_State* L = g->state();
+			std::size_t before = destroyed_objects;
+			for (std::size_t i = 0; i < gc_objects; ++i) {
+				lua_rawgeti(L, 1, static_cast<int>(i + 1));
+				if (lua_iscfunction(L, -1)) {
+					// stateful functions keep their user<F> as the first upvalue
+					lua_getupvalue(L, -1, 1);
+					lua_remove(L, -2);
+				}
+				if (lua_getmetatable(L, -1) == 0) {
+					lua_pop(L, 1);
+					continue;
+				}
+				lua_getfield(L, -1, "__gc");
+				if (lua_isnil(L, -1)) {
+					lua_pop(L, 3);
+					continue;
+				}
+				lua_pushvalue(L, -3);
+				lua_call(L, 1, 0);
+				lua_pop(L, 1);
+				lua_pushnil(L);
+				lua_setmetatable(L, -2);
+				lua_pop(L, 1);
+			}
+			destroyed += destroyed_objects - before;
+			++runs;
+		});
+		meter.counter("ns_per_object", meter.median() / static_cast<double>(gc_objects));
+		report_destroyed(meter, destroyed, runs);
+	}
+}
+
+BENCH_CASE("gc: full collection of 1M objects", "sol_value") {
+	measure_full_collection(meter, &push_value);
+}
+
+BENCH_CASE("gc: full collection of 1M objects", "sol_shared") {
+	measure_full_collection(meter, &push_shared);
+}
+
+BENCH_CASE("gc: full collection of 1M objects", "sol_closure") {
+	measure_full_collection(meter, &push_closure);
+}
+
+BENCH_CASE("gc: full collection of 1M objects", "plain_c") {
+	measure_full_collection(meter, &push_plain);
+}
+
+BENCH_CASE("gc: full collection of 1M objects", "plain_c_nogc") {
+	measure_full_collection(meter, &push_plain_no_finalizer);
+}
+
+BENCH_CASE("gc: incremental cycle over 1M objects", "sol_value") {
+	measure_incremental_steps(meter, &push_value);
+}
+
+BENCH_CASE("gc: incremental cycle over 1M objects", "sol_shared") {
+	measure_incremental_steps(meter, &push_shared);
+}
+
+BENCH_CASE("gc: incremental cycle over 1M objects", "sol_closure") {
+	measure_incremental_steps(meter, &push_closure);
+}
+
+BENCH_CASE("gc: incremental cycle over 1M objects", "plain_c") {
+	measure_incremental_steps(meter, &push_plain);
+}
+
+BENCH_CASE("gc: finalizers of 1M objects", "sol_value") {
+	measure_finalizers(meter, &push_value);
+}
+
+BENCH_CASE("gc: finalizers of 1M objects", "sol_shared") {
+	measure_finalizers(meter, &push_shared);
+}
+
+BENCH_CASE("gc: finalizers of 1M objects", "sol_closure") {
+	measure_finalizers(meter, &push_closure);
+}
+
+BENCH_CASE("gc: finalizers of 1M objects", "plain_c") {
+	measure_finalizers(meter, &push_plain);
+}
@@ -0,0 +1,284 @@
+#include "bench.hpp"
+
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+	// Synthetic usertypes: every synthetic<Id> is a distinct type (so it
+	// gets its own usertype_traits and metatables), while the members come
+	// from a shared base so the number of bound functions stays cheap to compile
+	// Each distinct type still costs a usertype_metatable instantiation per member
+	// count, so only a pool of pool_size types is compiled: larger counts
+	// register that pool into count / pool_size fresh states
+	const std::size_t pool_size = 25;
+
+	struct synthetic_base {
+		int value = 0;
+
+		template <std::size_t I>
+		int get() const {
+			return value + static_cast<int>(I);
+		}
+	};
+
+	template <std::size_t Id>
+	struct synthetic : synthetic_base {};
+
+	// bases<> chains: chained<Id, 0> derives from chained<Id, 1>, and so on
+	template <std::size_t Id, std::size_t Depth>
+	struct chained : chained<Id, Depth + 1> {
+		int level = static_cast<int>(Depth);
+	};
+
+	template <std::size_t Id>
+	struct chained<Id, 3> : synthetic_base {};
+
+	std::string type_name(std::size_t id, const char* prefix = "synthetic_") {
+		return prefix + std::to_string(id);
+	}
+
+	const char* member_name(std::size_t i) {
+		static std::vector<std::string> names;
+		if (names.empty()) {
+			for (std::size_t m = 0; m < 100; ++m) {
+				names.push_back("m" + std::to_string(m));
+			}
+		}
+		return names[i].c_str();
+	}
+
+	template <std::size_t... I>
+	auto member_args(std::index_sequence<I...>) {
+		return std::tuple_cat(std::make_tuple(member_name(I), &synthetic_base::template get<I>)...);
+	}
+
+	template <typename T, typename Tuple, std::size_t... J>
+	void register_with(std::false_type, sol::state& lua, const std::string& name, Tuple&& args, std::index_sequence<J...>) {
+		lua.new_usertype<T>(name, std::get<J>(args)...);
+	}
+
+	template <typename T, typename Tuple, std::size_t... J>
+	void register_with(std::true_type, sol::state& lua, const std::string& name, Tuple&& args, std::index_sequence<J...>) {
+		lua.new_simple_usertype<T>(name, std::get<J>(args)...);
+	}
+
+	template <typename T, bool simple, std::size_t Members, typename... Extra>
+	void register_one(sol::state& lua, const std::string& name, Extra&&... extra) {
+		auto args = std::tuple_cat(member_args(std::make_index_sequence<Members>()), std::forward_as_tuple(std::forward<Extra>(extra)...));
+		register_with<T>(std::integral_constant<bool, simple>(), lua, name, args, std::make_index_sequence<std::tuple_size<decltype(args)>::value>());
+	}
+
+	template <bool simple, std::size_t Members, std::size_t... Id>
+	void register_synthetic(sol::state& lua, std::index_sequence<Id...>) {
+		(void)sol::detail::swallow{ 0, (register_one<synthetic<Id>, simple, Members>(lua, type_name(Id)), 0)... };
+	}
+
+	template <bool simple, std::size_t Members, std::size_t Count>
+	void register_pool(sol::state& lua) {
+		register_synthetic<simple, Members>(lua, std::make_index_sequence<Count>());
+	}
+
+	template <std::size_t Id, std::size_t Members>
+	void register_chain(sol::state& lua) {
+		register_one<chained<Id, 3>, false, Members>(lua, type_name(Id, "chained_3_"));
+		register_one<chained<Id, 2>, false, 0>(lua, type_name(Id, "chained_2_"), "level", &chained<Id, 2>::level, sol::base_classes, sol::bases<chained<Id, 3>>());
+		register_one<chained<Id, 1>, false, 0>(lua, type_name(Id, "chained_1_"), "level", &chained<Id, 1>::level, sol::base_classes, sol::bases<chained<Id, 2>, chained<Id, 3>>());
+		register_one<chained<Id, 0>, false, 0>(lua, type_name(Id, "chained_0_"), "level", &chained<Id, 0>::level, sol::base_classes, sol::bases<chained<Id, 1>, chained<Id, 2>, chained<Id, 3>>());
+	}
+
+	template <std::size_t Members, std::size_t... Id>
+	void register_chains(sol::state& lua, std::index_sequence<Id...>) {
+		(void)sol::detail::swallow{ 0, (register_chain<Id, Members>(lua), 0)... };
+	}
+
+	template <std::size_t Members, std::size_t Count>
+	void register_chain_pool(sol::state& lua) {
+		register_chains<Members>(lua, std::make_index_sequence<Count>());
+	}
+
+	// The hand-written equivalent: one metatable per type, holding
+	// its methods and indexing itself
+	int c_get(lua_State* L) {
+		synthetic_base* self = *static_cast<synthetic_base**>(lua_touserdata(L, 1));
+		lua_pushinteger(L, self->value + static_cast<lua_Integer>(lua_tointeger(L, lua_upvalueindex(1))));
+		return 1;
+	}
+
+	void c_register(lua_State* L, const std::string& name, std::size_t members, const char* base = nullptr) {
+		luaL_newmetatable(L, name.c_str());
+		for (std::size_t m = 0; m < members; ++m) {
+			lua_pushinteger(L, static_cast<lua_Integer>(m));
+			lua_pushcclosure(L, &c_get, 1);
+			lua_setfield(L, -2, member_name(m));
+		}
+		lua_pushvalue(L, -1);
+		lua_setfield(L, -2, "__index");
+		if (base != nullptr) {
+			lua_createtable(L, 0, 1);
+			luaL_getmetatable(L, base);
+			lua_setfield(L, -2, "__index");
+			lua_setmetatable(L, -2);
+		}
+		lua_setglobal(L, name.c_str());
+	}
+
+	typedef std::unique_ptr<sol::state> state_ptr;
+	typedef std::unique_ptr<lua_State, void(*)(lua_State*)> bare_state_ptr;
+
+	bare_state_ptr new_bare_state() {
+		return bare_state_ptr(luaL_newstate(), &lua_close);
+	}
+
+	struct accounted_state {
+		sol::accounting_allocator allocator;
+		sol::state lua;
+
+		accounted_state() : lua(allocator) {}
+	};
+
+	// Bytes a registration leaves live in the state, after a full collection
+	template <typename Fx>
+	double bytes_per_usertype(std::size_t count, Fx&& registration) {
+		accounted_state s;
+		lua_gc(s.lua, LUA_GCCOLLECT, 0);
+		std::size_t before = s.allocator.live_bytes();
+		registration(s.lua);
+		lua_gc(s.lua, LUA_GCCOLLECT, 0);
+		return static_cast<double>(s.allocator.live_bytes() - before) / static_cast<double>(count);
+	}
+
+	// registration(lua) registers per_state usertypes, and is timed
+	// once for each of the count / per_state fresh states
+	template <typename Fx>
+	void measure_registration(bench::meter& meter, std::size_t count, std::size_t per_state, Fx&& registration) {
+		std::size_t states = count / per_state;
+		meter.measure_each([states]() {
+			std::vector<state_ptr> lua;
+			for (std::size_t i = 0; i < states; ++i) {
+				lua.emplace_back(new sol::state());
+			}
+			return lua;
+		}, [&registration](std::vector<state_ptr>& lua) {
+			for (auto& s : lua) {
+				registration(*s);
+			}
+		});
+		meter.counter("ns_per_usertype", meter.median() / static_cast<double>(count));
+		meter.counter("bytes_per_usertype", bytes_per_usertype(per_state, registration));
+	}
+
+	template <typename Fx>
+	void measure_c_registration(bench::meter& meter, std::size_t count, std::size_t per_state, Fx&& registration) {
+		std::size_t states = count / per_state;
+		meter.measure_each([states]() {
+			std::vector<bare_state_ptr> L;
+			for (std::size_t i = 0; i < states; ++i) {
+				L.push_back(new_bare_state());
+			}
+			return L;
+		}, [&registration](std::vector<bare_state_ptr>& L) {
+			for (auto& s : L) {
+				registration(s.get());
+			}
+		});
+		meter.counter("ns_per_usertype", meter.median() / static_cast<double>(count));
+		sol::accounting_allocator allocator;
+		lua_State* L = lua_newstate(&sol::accounting_allocator::allocate, &allocator);
+		lua_gc(L, LUA_GCCOLLECT, 0);
+		std::size_t before = allocator.live_bytes();
+		registration(L);
+		lua_gc(L, LUA_GCCOLLECT, 0);
+		meter.counter("bytes_per_usertype", static_cast<double>(allocator.live_bytes() - before) / static_cast<double>(per_state));
+		lua_close(L);
+	}
+
+	template <std::size_t Count, std::size_t Members>
+	void c_register_synthetic(lua_State* L) {
+		for (std::size_t i = 0; i < Count; ++i) {
+			c_register(L, type_name(i), Members);
+		}
+	}
+
+	template <std::size_t Count, std::size_t Members>
+	void c_register_chains(lua_State* L) {
+		for (std::size_t i = 0; i < Count; ++i) {
+			c_register(L, type_name(i, "chained_3_"), Members);
+			c_register(L, type_name(i, "chained_2_"), 1, type_name(i, "chained_3_").c_str());
+			c_register(L, type_name(i, "chained_1_"), 1, type_name(i, "chained_2_").c_str());
+			c_register(L, type_name(i, "chained_0_"), 1, type_name(i, "chained_1_").c_str());
+		}
+	}
+}
+
+BENCH_CASE("startup: state construction", "sol") {
+	meter.measure([]() {
+		sol::state lua;
+		bench::do_not_optimize(lua);
+	});
+}
+
+BENCH_CASE("startup: state construction", "plain_c") {
+	meter.measure([]() {
+		bare_state_ptr L = new_bare_state();
+		bench::do_not_optimize(L);
+	});
+}
+
+BENCH_CASE("startup: open_libraries", "sol") {
+	meter.measure_each([]() { return state_ptr(new sol::state()); }, [](state_ptr& lua) {
+		lua->open_libraries(sol::lib::base, sol::lib::package, sol::lib::coroutine, sol::lib::string, sol::lib::os, sol::lib::math, sol::lib::table, sol::lib::debug, sol::lib::io);
+	});
+}
+
+BENCH_CASE("startup: open_libraries", "plain_c") {
+	meter.measure_each(&new_bare_state, [](bare_state_ptr& L) {
+		luaL_openlibs(L.get());
+	});
+}
+
+BENCH_CASE("startup: 10 usertypes x 100 members", "sol") {
+	measure_registration(meter, 10, 10, &register_pool<false, 100, 10>);
+}
+
+BENCH_CASE("startup: 10 usertypes x 100 members", "sol_simple") {
+	measure_registration(meter, 10, 10, &register_pool<true, 100, 10>);
+}
+
+BENCH_CASE("startup: 10 usertypes x 100 members", "plain_c") {
+	measure_c_registration(meter, 10, 10, &c_register_synthetic<10, 100>);
+}
+
+BENCH_CASE("startup: 100 usertypes x 20 members", "sol") {
+	measure_registration(meter, 100, pool_size, &register_pool<false, 20, pool_size>);
+}
+
+BENCH_CASE("startup: 100 usertypes x 20 members", "sol_simple") {
+	measure_registration(meter, 100, pool_size, &register_pool<true, 20, pool_size>);
+}
+
+BENCH_CASE("startup: 100 usertypes x 20 members", "plain_c") {
+	measure_c_registration(meter, 100, pool_size, &c_register_synthetic<pool_size, 20>);
+}
+
+BENCH_CASE("startup: 1000 usertypes x 5 members", "sol") {
+	measure_registration(meter, 1000, pool_size, &register_pool<false, 5, pool_size>);
+}
+
+BENCH_CASE("startup: 1000 usertypes x 5 members", "sol_simple") {
+	measure_registration(meter, 1000, pool_size, &register_pool<true, 5, pool_size>);
+}
+
+BENCH_CASE("startup: 1000 usertypes x 5 members", "plain_c") {
+	measure_c_registration(meter, 1000, pool_size, &c_register_synthetic<pool_size, 5>);
+}
+
+BENCH_CASE("startup: 100 x 4-level bases<> chains", "sol") {
+	measure_registration(meter, 400, pool_size * 4, &register_chain_pool<10, pool_size>);
+}
+
+BENCH_CASE("startup: 100 x 4-level bases<> chains", "plain_c") {
+	measure_c_registration(meter, 400, pool_size * 4, &c_register_chains<pool_size, 10>);
+}
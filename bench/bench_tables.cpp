@@ -0,0 +1,49 @@
+#include "bench.hpp"
+
+namespace {
+	const char table_script[] = "t = { value = 24 }";
+}
+
+BENCH_CASE("table get (proxy)", "sol") {
+	sol::state lua;
+	lua.script(table_script);
+	meter.measure([&lua]() {
+		int v = lua["t"]["value"];
+		bench::do_not_optimize(v);
+	});
+}
+
+BENCH_CASE("table get (proxy)", "plain_c") {
+	bench::plain_state s;
+	bench::run_script(s.L, table_script);
+	lua_State* L = s.L;
+	meter.measure([L]() {
+		lua_getglobal(L, "t");
+		lua_getfield(L, -1, "value");
+		int v = static_cast<int>(lua_tointeger(L, -1));
+		lua_pop(L, 2);
+		bench::do_not_optimize(v);
+	});
+}
+
+BENCH_CASE("table set (proxy)", "sol") {
+	sol::state lua;
+	lua.script(table_script);
+	int v = 0;
+	meter.measure([&lua, &v]() {
+		lua["t"]["value"] = ++v;
+	});
+}
+
+BENCH_CASE("table set (proxy)", "plain_c") {
+	bench::plain_state s;
+	bench::run_script(s.L, table_script);
+	lua_State* L = s.L;
+	int v = 0;
+	meter.measure([L, &v]() {
+		lua_getglobal(L, "t");
+		lua_pushinteger(L, ++v);
+		lua_setfield(L, -2, "value");
+		lua_pop(L, 1);
+	});
+}
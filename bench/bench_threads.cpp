@@ -0,0 +1,337 @@
+#include "bench.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstring>
+#include <new>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+	struct scaling_base {
+		int base = 1;
+		virtual ~scaling_base() {}
+	};
+
+	struct scaling_object : scaling_base {
+		int var = 0;
+
+		int get() const {
+			return var;
+		}
+
+		void set(int v) {
+			var = v;
+		}
+	};
+
+	int read_base(scaling_base& b) {
+		return b.base;
+	}
+
+	// One operation: construct a usertype, call members, touch a variable,
+	// cast to a base and call a free function, all from inside Lua
+	const char scaling_step[] = R"(
+function scaling_step (i)
+	local o = scaling_object.new()
+	o:set(i)
+	o.var = o:get() + 1
+	return add(o.var, read_base(o))
+end
+)";
+
+	// Each worker owns one of these and only ever touches it from its own thread
+	struct sol_workload {
+		sol::state lua;
+		sol::protected_function step;
+
+		sol_workload() {
+			lua.open_libraries(sol::lib::base);
+			lua.new_usertype<scaling_object>("scaling_object",
+				"get", &scaling_object::get,
+				"set", &scaling_object::set,
+				"var", &scaling_object::var,
+				sol::base_classes, sol::bases<scaling_base>()
+			);
+			lua.set_function("add", [](int a, int b) { return a + b; });
+			lua.set_function("read_base", &read_base);
+			lua.script(scaling_step);
+			step = lua["scaling_step"];
+		}
+
+		void run(std::size_t n) {
+			for (std::size_t i = 0; i < n; ++i) {
+				int r = step(static_cast<int>(i));
+				bench::do_not_optimize(r);
+			}
+		}
+	};
+
+	// The hand-written equivalent, without any inheritance support
+	const char c_scaling_metatable[] = "bench.c_scaling_object";
+
+	scaling_object* c_to_scaling(lua_State* L) {
+		return *static_cast<scaling_object**>(luaL_checkudata(L, 1, c_scaling_metatable));
+	}
+
+	int c_scaling_new(lua_State* L) {
+		scaling_object** p = static_cast<scaling_object**>(lua_newuserdata(L, sizeof(scaling_object*) + sizeof(scaling_object)));
+		*p = new (p + 1) scaling_object();
+		luaL_getmetatable(L, c_scaling_metatable);
+		lua_setmetatable(L, -2);
+		return 1;
+	}
+
+	int c_scaling_gc(lua_State* L) {
+		c_to_scaling(L)->~scaling_object();
+		return 0;
+	}
+
+	int c_scaling_get(lua_State* L) {
+		lua_pushinteger(L, c_to_scaling(L)->get());
+		return 1;
+	}
+
+	int c_scaling_set(lua_State* L) {
+		c_to_scaling(L)->set(static_cast<int>(luaL_checkinteger(L, 2)));
+		return 0;
+	}
+
+	int c_scaling_index(lua_State* L) {
+		scaling_object* self = c_to_scaling(L);
+		const char* key = luaL_checkstring(L, 2);
+		if (std::strcmp(key, "var") == 0) {
+			lua_pushinteger(L, self->var);
+			return 1;
+		}
+		lua_getmetatable(L, 1);
+		lua_getfield(L, -1, "methods");
+		lua_getfield(L, -1, key);
+		return 1;
+	}
+
+	int c_scaling_new_index(lua_State* L) {
+		c_to_scaling(L)->var = static_cast<int>(luaL_checkinteger(L, 3));
+		return 0;
+	}
+
+	int c_add(lua_State* L) {
+		lua_pushinteger(L, luaL_checkinteger(L, 1) + luaL_checkinteger(L, 2));
+		return 1;
+	}
+
+	int c_read_base(lua_State* L) {
+		lua_pushinteger(L, read_base(*c_to_scaling(L)));
+		return 1;
+	}
+
+	struct plain_c_workload {
+		bench::plain_state state;
+
+		plain_c_workload() {
+			lua_State* L = state.L;
+			luaL_newmetatable(L, c_scaling_metatable);
+			lua_createtable(L, 0, 2);
+			lua_pushcfunction(L, &c_scaling_get);
+			lua_setfield(L, -2, "get");
+			lua_pushcfunction(L, &c_scaling_set);
+			lua_setfield(L, -2, "set");
+			lua_setfield(L, -2, "methods");
+			lua_pushcfunction(L, &c_scaling_index);
+			lua_setfield(L, -2, "__index");
+			lua_pushcfunction(L, &c_scaling_new_index);
+			lua_setfield(L, -2, "__newindex");
+			lua_pushcfunction(L, &c_scaling_gc);
+			lua_setfield(L, -2, "__gc");
+			lua_pop(L, 1);
+			lua_createtable(L, 0, 1);
+			lua_pushcfunction(L, &c_scaling_new);
+			lua_setfield(L, -2, "new");
+			lua_setglobal(L, "scaling_object");
+			lua_pushcfunction(L, &c_add);
+			lua_setglobal(L, "add");
+			lua_pushcfunction(L, &c_read_base);
+			lua_setglobal(L, "read_base");
+			bench::run_script(L, scaling_step);
+		}
+
+		void run(std::size_t n) {
+			lua_State* L = state.L;
+			for (std::size_t i = 0; i < n; ++i) {
+				lua_getglobal(L, "scaling_step");
+				lua_pushinteger(L, static_cast<lua_Integer>(i));
+				if (lua_pcall(L, 1, 1, 0) != 0) {
+					throw sol::error(lua_tostring(L, -1));
+				}
+				lua_pop(L, 1);
+			}
+		}
+	};
+
+	// A fixed set of threads, each building its own Workload (and so its own
+	// lua_State) on the thread that uses it. run(n) splits n operations
+	// between the threads and returns when all of them are done
+	template <typename Workload>
+	class state_pool {
+	private:
+		std::vector<std::thread> threads;
+		std::vector<std::size_t> work;
+		std::mutex lock;
+		std::condition_variable started;
+		std::condition_variable finished;
+		std::size_t generation;
+		std::size_t pending;
+		bool quitting;
+		std::exception_ptr failure;
+
+		void worker(std::size_t index) {
+			std::unique_ptr<Workload> workload;
+			std::size_t seen = 0;
+			try {
+				workload.reset(new Workload());
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> guard(lock);
+				failure = std::current_exception();
+			}
+			std::unique_lock<std::mutex> guard(lock);
+			if (--pending == 0) {
+				finished.notify_one();
+			}
+			for (;;) {
+				started.wait(guard, [this, seen]() { return quitting || generation != seen; });
+				if (quitting) {
+					return;
+				}
+				seen = generation;
+				std::size_t n = work[index];
+				guard.unlock();
+				try {
+					if (workload) {
+						workload->run(n);
+					}
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> failguard(lock);
+					failure = std::current_exception();
+				}
+				guard.lock();
+				if (--pending == 0) {
+					finished.notify_one();
+				}
+			}
+		}
+
+		void wait_for_workers(std::unique_lock<std::mutex>& guard) {
+			finished.wait(guard, [this]() { return pending == 0; });
+			if (failure) {
+				std::exception_ptr e = failure;
+				failure = nullptr;
+				std::rethrow_exception(e);
+			}
+		}
+
+		void shutdown() {
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				quitting = true;
+			}
+			started.notify_all();
+			for (auto& t : threads) {
+				t.join();
+			}
+		}
+
+	public:
+		state_pool(std::size_t count) : work(count, 0), generation(0), pending(count), quitting(false) {
+			threads.reserve(count);
+			for (std::size_t i = 0; i < count; ++i) {
+				threads.emplace_back(&state_pool::worker, this, i);
+			}
+			try {
+				std::unique_lock<std::mutex> guard(lock);
+				wait_for_workers(guard);
+			}
+			catch (...) {
+				shutdown();
+				throw;
+			}
+		}
+
+		state_pool(const state_pool&) = delete;
+		state_pool& operator=(const state_pool&) = delete;
+
+		~state_pool() {
+			shutdown();
+		}
+
+		void run(std::size_t n) {
+			std::unique_lock<std::mutex> guard(lock);
+			for (std::size_t i = 0; i < work.size(); ++i) {
+				work[i] = n / work.size() + (i < n % work.size() ? 1 : 0);
+			}
+			pending = work.size();
+			++generation;
+			started.notify_all();
+			wait_for_workers(guard);
+		}
+	};
+
+	// ns per operation with one thread, per implementation, so that
+	// the later thread counts can report how close they get to linear
+	std::map<std::string, double>& single_thread_baselines() {
+		static std::map<std::string, double> baselines;
+		return baselines;
+	}
+
+	template <typename Workload>
+	void measure_scaling(bench::meter& meter, const std::string& implementation, std::size_t threadcount) {
+		state_pool<Workload> pool(threadcount);
+		meter.measure_batch([&pool](std::size_t n) {
+			pool.run(n);
+		});
+		meter.counter("ops_per_s", 1e9 / meter.median());
+		if (threadcount == 1) {
+			single_thread_baselines()[implementation] = meter.median();
+			return;
+		}
+		auto baseline = single_thread_baselines().find(implementation);
+		if (baseline != single_thread_baselines().end()) {
+			double speedup = baseline->second / meter.median();
+			meter.counter("speedup", speedup);
+			meter.counter("efficiency", speedup / static_cast<double>(threadcount));
+		}
+	}
+
+	// 1, 2, 4, ... threads, ending at the number of hardware threads
+	std::vector<std::size_t> thread_counts() {
+		std::size_t cores = (std::max)(1u, std::thread::hardware_concurrency());
+		std::vector<std::size_t> counts;
+		for (std::size_t n = 1; n < cores; n *= 2) {
+			counts.push_back(n);
+		}
+		counts.push_back(cores);
+		return counts;
+	}
+
+	// The thread counts depend on the machine, so the cases are registered here
+	// rather than with BENCH_CASE; all of them measure aggregate throughput,
+	// so with perfect scaling ns/op halves every time the thread count doubles
+	struct scaling_cases {
+		scaling_cases() {
+			for (std::size_t threadcount : thread_counts()) {
+				std::string category = "threads: independent states x " + std::to_string(threadcount);
+				bench::registry().push_back(bench::case_entry{ category, "sol", [threadcount](bench::meter& meter) {
+					measure_scaling<sol_workload>(meter, "sol", threadcount);
+				} });
+				bench::registry().push_back(bench::case_entry{ category, "plain_c", [threadcount](bench::meter& meter) {
+					measure_scaling<plain_c_workload>(meter, "plain_c", threadcount);
+				} });
+			}
+		}
+	} register_scaling_cases;
+}
@@ -0,0 +1,329 @@
+#include "bench.hpp"
+
+#include <cstring>
+#include <new>
+
+namespace {
+	struct bench_object {
+		int var = 0;
+
+		int get() const {
+			return var;
+		}
+
+		void set(int v) {
+			var = v;
+		}
+	};
+
+	struct bench_base_a {
+		int a = 1;
+		virtual ~bench_base_a() {}
+	};
+
+	struct bench_base_b {
+		int b = 2;
+		virtual ~bench_base_b() {}
+	};
+
+	struct bench_derived : bench_base_a, bench_base_b {
+		int d = 3;
+	};
+
+	int read_b(bench_base_b& b) {
+		return b.b;
+	}
+
+	const char member_function_loop[] = R"(
+function member_function_loop (n)
+	local o = o
+	for i = 1, n do
+		o:set(i)
+	end
+end
+)";
+
+	const char member_variable_get_loop[] = R"(
+function member_variable_get_loop (n)
+	local o = o
+	local x = 0
+	for i = 1, n do
+		x = o.var
+	end
+	return x
+end
+)";
+
+	const char member_variable_set_loop[] = R"(
+function member_variable_set_loop (n)
+	local o = o
+	for i = 1, n do
+		o.var = i
+	end
+end
+)";
+
+	const char base_cast_loop[] = R"(
+function base_cast_loop (n)
+	local d = d
+	local x = 0
+	for i = 1, n do
+		x = read_b(d)
+	end
+	return x
+end
+)";
+
+	// plain C API versions of the above,
+	// written the way one would by hand
+	const char c_object_metatable[] = "bench.c_object";
+	const char c_derived_metatable[] = "bench.c_derived";
+
+	bench_object* c_to_object(lua_State* L) {
+		return static_cast<bench_object*>(lua_touserdata(L, 1));
+	}
+
+	int c_object_get(lua_State* L) {
+		lua_pushinteger(L, c_to_object(L)->get());
+		return 1;
+	}
+
+	int c_object_set(lua_State* L) {
+		c_to_object(L)->set(static_cast<int>(lua_tointeger(L, 2)));
+		return 0;
+	}
+
+	int c_object_index(lua_State* L) {
+		const char* key = lua_tostring(L, 2);
+		if (key != nullptr && std::strcmp(key, "var") == 0) {
+			lua_pushinteger(L, c_to_object(L)->var);
+			return 1;
+		}
+		// fall back to the method table
+		lua_getmetatable(L, 1);
+		lua_getfield(L, -1, "methods");
+		lua_pushvalue(L, 2);
+		lua_rawget(L, -2);
+		return 1;
+	}
+
+	int c_object_new_index(lua_State* L) {
+		const char* key = lua_tostring(L, 2);
+		if (key != nullptr && std::strcmp(key, "var") == 0) {
+			c_to_object(L)->var = static_cast<int>(lua_tointeger(L, 3));
+			return 0;
+		}
+		return luaL_error(L, "no such member");
+	}
+
+	void c_register_object(lua_State* L, bool withvariables) {
+		bench_object* obj = static_cast<bench_object*>(lua_newuserdata(L, sizeof(bench_object)));
+		new (obj) bench_object();
+		luaL_newmetatable(L, c_object_metatable);
+		lua_createtable(L, 0, 2);
+		lua_pushcfunction(L, &c_object_get);
+		lua_setfield(L, -2, "get");
+		lua_pushcfunction(L, &c_object_set);
+		lua_setfield(L, -2, "set");
+		if (withvariables) {
+			lua_setfield(L, -2, "methods");
+			lua_pushcfunction(L, &c_object_index);
+			lua_setfield(L, -2, "__index");
+			lua_pushcfunction(L, &c_object_new_index);
+			lua_setfield(L, -2, "__newindex");
+		}
+		else {
+			lua_setfield(L, -2, "__index");
+		}
+		lua_setmetatable(L, -2);
+		lua_setglobal(L, "o");
+	}
+
+	int c_read_b(lua_State* L) {
+		// a hand-written version knows the exact derived metatable,
+		// so the cast is just a metatable compare and a static_cast
+		if (lua_getmetatable(L, 1) == 0) {
+			return luaL_error(L, "expected a userdata");
+		}
+		if (lua_rawequal(L, -1, lua_upvalueindex(1)) != 1) {
+			return luaL_error(L, "wrong userdata type");
+		}
+		lua_pop(L, 1);
+		bench_derived* d = *static_cast<bench_derived**>(lua_touserdata(L, 1));
+		lua_pushinteger(L, read_b(*static_cast<bench_base_b*>(d)));
+		return 1;
+	}
+
+	void sol_register_object(sol::state& lua, bool withvariables) {
+		if (withvariables) {
+			lua.new_usertype<bench_object>("bench_object",
+				"get", &bench_object::get,
+				"set", &bench_object::set,
+				"var", &bench_object::var
+			);
+		}
+		else {
+			lua.new_usertype<bench_object>("bench_object",
+				"get", &bench_object::get,
+				"set", &bench_object::set
+			);
+		}
+		lua["o"] = bench_object();
+	}
+
+	void sol_register_erased_object(sol::state& lua, bool withvariables) {
+		if (withvariables) {
+			lua.new_erased_usertype<bench_object>("bench_object",
+				"get", &bench_object::get,
+				"set", &bench_object::set,
+				"var", &bench_object::var
+			);
+		}
+		else {
+			lua.new_erased_usertype<bench_object>("bench_object",
+				"get", &bench_object::get,
+				"set", &bench_object::set
+			);
+		}
+		lua["o"] = bench_object();
+	}
+}
+
+BENCH_CASE("member function call", "sol") {
+	sol::state lua;
+	sol_register_object(lua, false);
+	lua.script(member_function_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "member_function_loop", n); });
+}
+
+BENCH_CASE("member function call", "sol_erased") {
+	sol::state lua;
+	sol_register_erased_object(lua, false);
+	lua.script(member_function_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "member_function_loop", n); });
+}
+
+BENCH_CASE("member function call", "plain_c") {
+	bench::plain_state s;
+	c_register_object(s.L, false);
+	bench::run_script(s.L, member_function_loop);
+	meter.measure_batch([&s](std::size_t n) { bench::run_lua_loop(s.L, "member_function_loop", n); });
+}
+
+BENCH_CASE("member function call (with variables)", "sol") {
+	sol::state lua;
+	sol_register_object(lua, true);
+	lua.script(member_function_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "member_function_loop", n); });
+}
+
+BENCH_CASE("member function call (with variables)", "sol_erased") {
+	sol::state lua;
+	sol_register_erased_object(lua, true);
+	lua.script(member_function_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "member_function_loop", n); });
+}
+
+BENCH_CASE("member function call (with variables)", "plain_c") {
+	bench::plain_state s;
+	c_register_object(s.L, true);
+	bench::run_script(s.L, member_function_loop);
+	meter.measure_batch([&s](std::size_t n) { bench::run_lua_loop(s.L, "member_function_loop", n); });
+}
+
+BENCH_CASE("member variable get", "sol") {
+	sol::state lua;
+	sol_register_object(lua, true);
+	lua.script(member_variable_get_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "member_variable_get_loop", n); });
+}
+
+BENCH_CASE("member variable get", "sol_erased") {
+	sol::state lua;
+	sol_register_erased_object(lua, true);
+	lua.script(member_variable_get_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "member_variable_get_loop", n); });
+}
+
+BENCH_CASE("member variable get", "plain_c") {
+	bench::plain_state s;
+	c_register_object(s.L, true);
+	bench::run_script(s.L, member_variable_get_loop);
+	meter.measure_batch([&s](std::size_t n) { bench::run_lua_loop(s.L, "member_variable_get_loop", n); });
+}
+
+BENCH_CASE("member variable set", "sol") {
+	sol::state lua;
+	sol_register_object(lua, true);
+	lua.script(member_variable_set_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "member_variable_set_loop", n); });
+}
+
+BENCH_CASE("member variable set", "sol_erased") {
+	sol::state lua;
+	sol_register_erased_object(lua, true);
+	lua.script(member_variable_set_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "member_variable_set_loop", n); });
+}
+
+BENCH_CASE("member variable set", "plain_c") {
+	bench::plain_state s;
+	c_register_object(s.L, true);
+	bench::run_script(s.L, member_variable_set_loop);
+	meter.measure_batch([&s](std::size_t n) { bench::run_lua_loop(s.L, "member_variable_set_loop", n); });
+}
+
+BENCH_CASE("base class cast", "sol") {
+	sol::state lua;
+	lua.new_usertype<bench_base_a>("bench_base_a", "a", &bench_base_a::a);
+	lua.new_usertype<bench_base_b>("bench_base_b", "b", &bench_base_b::b);
+	lua.new_usertype<bench_derived>("bench_derived",
+		"d", &bench_derived::d,
+		sol::base_classes, sol::bases<bench_base_a, bench_base_b>()
+	);
+	lua.set_function("read_b", &read_b);
+	bench_derived d;
+	lua["d"] = &d;
+	lua.script(base_cast_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "base_cast_loop", n); });
+}
+
+BENCH_CASE("base class cast", "sol_erased") {
+	sol::state lua;
+	lua.new_erased_usertype<bench_base_a>("bench_base_a", "a", &bench_base_a::a);
+	lua.new_erased_usertype<bench_base_b>("bench_base_b", "b", &bench_base_b::b);
+	lua.new_erased_usertype<bench_derived>("bench_derived",
+		"d", &bench_derived::d,
+		sol::base_classes, sol::bases<bench_base_a, bench_base_b>()
+	);
+	lua.set_function("read_b", &read_b);
+	bench_derived d;
+	lua["d"] = &d;
+	lua.script(base_cast_loop);
+	lua_State* L = lua.lua_state();
+	meter.measure_batch([L](std::size_t n) { bench::run_lua_loop(L, "base_cast_loop", n); });
+}
+
+BENCH_CASE("base class cast", "plain_c") {
+	bench::plain_state s;
+	bench_derived d;
+	bench_derived** pd = static_cast<bench_derived**>(lua_newuserdata(s.L, sizeof(bench_derived*)));
+	*pd = &d;
+	luaL_newmetatable(s.L, c_derived_metatable);
+	lua_setmetatable(s.L, -2);
+	lua_setglobal(s.L, "d");
+	luaL_getmetatable(s.L, c_derived_metatable);
+	lua_pushcclosure(s.L, &c_read_b, 1);
+	lua_setglobal(s.L, "read_b");
+	bench::run_script(s.L, base_cast_loop);
+	meter.measure_batch([&s](std::size_t n) { bench::run_lua_loop(s.L, "base_cast_loop", n); });
+}
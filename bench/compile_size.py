@@ -0,0 +1,114 @@
+#!/usr/bin/env python
+
+# Measures what binding a usertype costs at build time: for every member count
+# and registration mode, a translation unit binding one synthetic class is
+# generated, compiled on its own, and timed, and the object file is measured.
+
+import os, re, time, json, shutil, argparse, subprocess, tempfile
+
+modes = {
+    'usertype': 'new_usertype',
+    'erased': 'new_erased_usertype',
+    'simple': 'new_simple_usertype',
+}
+
+def member_list(n):
+    # cycles through the three shapes bindings usually come in,
+    # so that both modes see the same mix of functions and variables
+    members = []
+    for i in range(n):
+        shape = i % 3
+        if shape == 0:
+            members.append(('get_{}'.format(i), 'int get_{}() const {{ return value + {}; }}'.format(i, i)))
+        elif shape == 1:
+            members.append(('set_{}'.format(i), 'void set_{}(int x) {{ value = x + {}; }}'.format(i, i)))
+        else:
+            members.append(('v_{}'.format(i), 'int v_{} = 0;'.format(i)))
+    return members
+
+def generate(mode, n):
+    members = member_list(n)
+    lines = ['#include <sol.hpp>', '', 'struct bound {', '\tint value = 0;']
+    lines.extend('\t{}'.format(decl) for (name, decl) in members)
+    lines.extend(['};', '', 'void register_bound(sol::state& lua) {'])
+    lines.append('\tlua.{}<bound>("bound"{}'.format(modes[mode], ',' if members else ''))
+    bindings = ['\t\t"{0}", &bound::{0}'.format(name) for (name, decl) in members]
+    lines.append(',\n'.join(bindings))
+    lines.extend(['\t);', '}', ''])
+    return '\n'.join(lines)
+
+def text_size(obj):
+    # the code the bindings generate, without symbol tables and debug info
+    size = shutil.which('size') if hasattr(shutil, 'which') else None
+    if size is None:
+        return None
+    try:
+        out = subprocess.check_output([size, obj]).decode('utf-8', 'replace').splitlines()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+    if len(out) < 2:
+        return None
+    return int(out[1].split()[0])
+
+def measure(args, mode, n, workdir):
+    source = os.path.join(workdir, '{}_{}.cpp'.format(mode, n))
+    obj = replace_extension(source, '.o')
+    with open(source, 'w') as f:
+        f.write(generate(mode, n))
+    command = [args.cxx] + args.cxx_flags + ['-c', source, '-o', obj]
+    times = []
+    for sample in range(args.samples):
+        start = time.time()
+        subprocess.check_call(command)
+        times.append(time.time() - start)
+    times.sort()
+    return {
+        'mode': mode,
+        'members': n,
+        'compile_seconds': times[len(times) // 2],
+        'compile_seconds_min': times[0],
+        'object_bytes': os.path.getsize(obj),
+        'text_bytes': text_size(obj),
+    }
+
+def replace_extension(f, e):
+    (root, ext) = os.path.splitext(f)
+    return root + e
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--cxx', metavar='<compiler>', help='compiler to measure with (default: env.CXX=g++)', default=os.environ.get('CXX', 'g++'))
+parser.add_argument('--cxx-flags', help='flags passed to the compiler, as given to bootstrap.py', default='-std=c++14 -O3 -DNDEBUG -I.')
+parser.add_argument('--members', type=int, nargs='+', help='member counts to generate', default=[0, 10, 50, 100, 200])
+parser.add_argument('--modes', nargs='+', choices=sorted(modes.keys()), default=['usertype', 'erased', 'simple'])
+parser.add_argument('--samples', type=int, help='compilations per case (the median is reported)', default=3)
+parser.add_argument('--output', metavar='<file>', help='write the results as JSON to this file')
+args = parser.parse_args()
+args.cxx_flags = [p.strip('"\'') for p in re.split("( |\\\".*?\\\"|'.*?')", args.cxx_flags) if p.strip()]
+
+workdir = tempfile.mkdtemp(prefix='sol_compile_bench_')
+results = []
+try:
+    for n in args.members:
+        for mode in args.modes:
+            results.append(measure(args, mode, n, workdir))
+finally:
+    shutil.rmtree(workdir, ignore_errors=True)
+
+# the 0-member case is the cost of the header alone:
+# everything else is reported on top of it, per member
+baselines = dict((r['mode'], r) for r in results if r['members'] == 0)
+print('{:<10} {:>8} {:>12} {:>14} {:>12} {:>16}'.format('mode', 'members', 'compile (s)', 'object (KiB)', 'text (KiB)', 'text/member (B)'))
+for r in results:
+    base = baselines.get(r['mode'])
+    per_member = None
+    if base is not None and r['members'] > 0 and r['text_bytes'] is not None and base['text_bytes'] is not None:
+        per_member = (r['text_bytes'] - base['text_bytes']) / float(r['members'])
+    r['text_bytes_per_member'] = per_member
+    print('{:<10} {:>8} {:>12.2f} {:>14.1f} {:>12} {:>16}'.format(r['mode'], r['members'], r['compile_seconds'],
+        r['object_bytes'] / 1024.0,
+        '-' if r['text_bytes'] is None else '{:.1f}'.format(r['text_bytes'] / 1024.0),
+        '-' if per_member is None else '{:.0f}'.format(per_member)))
+
+if args.output:
+    with open(args.output, 'w') as f:
+        json.dump({ 'cxx': args.cxx, 'cxx_flags': args.cxx_flags, 'results': results }, f, indent = 4)
@@ -40,6 +40,7 @@ parser = argparse.ArgumentParser()
 parser.add_argument('--debug', action='store_true', help='compile with debug flags')
 parser.add_argument('--cxx', metavar='<compiler>', help='compiler name to use (default: env.CXX=%s)' % cxx, default=cxx)
 parser.add_argument('--cxx-flags', help='additional flags passed to the compiler', default='')
+parser.add_argument('--instrumented', action='store_true', help='compile with SOL_BINDING_STATS, SOL_HOT_PATH_COUNTERS, SOL_CALL_LATENCY and SOL_HEAP_ORIGINS defined')
 parser.add_argument('--ci', action='store_true', help=argparse.SUPPRESS)
 parser.add_argument('--testing', action='store_true', help=argparse.SUPPRESS)
 parser.add_argument('--lua-lib', help='lua library name (without the lib on *nix).', default='lua')
@@ -72,6 +73,9 @@ if sys.platform == 'win32':
 if not args.lua_lib:
      args.lua_lib = 'lua'
 
+if args.instrumented:
+    cxxflags.extend(['-DSOL_BINDING_STATS', '-DSOL_HOT_PATH_COUNTERS', '-DSOL_CALL_LATENCY', '-DSOL_HEAP_ORIGINS'])
+
 if args.debug:
     cxxflags.extend(['-g', '-O0'])
 else:
@@ -124,6 +128,7 @@ if args.testing:
 
 if 'linux' in sys.platform:
     ldflags.extend(libraries(['dl']))
+    ldflags.append('-pthread')
 
 builddir = 'bin'
 objdir = 'obj'
@@ -139,6 +144,20 @@ for f in glob.glob('test*.cpp'):
     tests_inputs.append(f)
     tests_object_files.append(obj)
 
+bench_inputs = []
+bench_object_files = []
+for f in glob.glob(os.path.join('bench', '*.cpp')):
+    obj = object_file(f)
+    bench_inputs.append(f)
+    bench_object_files.append(obj)
+
+if 'win32' in sys.platform:
+     bench = os.path.join(builddir, 'bench.exe')
+else:
+     bench = os.path.join(builddir, 'bench')
+bench_results = os.path.join(builddir, 'bench.json')
+compile_bench_results = os.path.join(builddir, 'compile_bench.json')
+
 examples = []
 examples_input = []
 for f in glob.glob('examples/*.cpp'):
@@ -168,6 +187,8 @@ ninja.rule('compile', command = '$cxx -MMD -MF $out.d -c $cxxflags -Werror $in -
                       description = 'Compiling $in to $out')
 ninja.rule('link', command = '$cxx $cxxflags $in -o $out $ldflags', description = 'Creating $out')
 ninja.rule('tests_runner', command = tests)
+ninja.rule('bench_runner', command = '{} --output {}'.format(bench, bench_results))
+ninja.rule('compile_bench_runner', command = 'python {} --cxx $cxx --cxx-flags \'$cxxflags\' --output {}'.format(os.path.join('bench', 'compile_size.py'), compile_bench_results))
 ninja.rule('examples_runner', command = 'cmd /c ' + (' && '.join(examples)) if 'win32' in sys.platform else ' && '.join(examples) )
 ninja.rule('example', command = '$cxx $cxxflags $in -o $out $ldflags')
 ninja.rule('installer', command = copy_command)
@@ -180,14 +201,21 @@ ninja.build('build.ninja', 'bootstrap', implicit = sys.argv[0])
 for obj, f in zip(tests_object_files, tests_inputs):
     ninja.build(obj, 'compile', inputs = f)
 
+for obj, f in zip(bench_object_files, bench_inputs):
+    ninja.build(obj, 'compile', inputs = f)
+
 for example, f in zip(examples, examples_input):
     ninja.build(example, 'example', inputs = f)
 
 ninja.build(tests, 'link', inputs = tests_object_files)
+ninja.build(bench, 'link', inputs = bench_object_files)
 ninja.build('tests', 'phony', inputs = tests)
+ninja.build('bench', 'phony', inputs = bench)
 ninja.build('examples', 'phony', inputs = examples)
 ninja.build('install', 'installer', inputs = args.install_dir)
 ninja.build('uninstall', 'uninstaller')
 ninja.build('run', 'tests_runner', implicit = 'tests')
 ninja.build('run_examples', 'examples_runner', implicit = 'examples')
+ninja.build('run_bench', 'bench_runner', implicit = 'bench')
+ninja.build('run_compile_bench', 'compile_bench_runner')
 ninja.default('run run_examples')
@@ -0,0 +1,58 @@
+#include <sol.hpp>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// prints how many bytes sol's userdata, closures and
+// registrations take for a few typical types
+
+struct vec3 {
+	float x = 0, y = 0, z = 0;
+
+	float length_squared() const {
+		return x * x + y * y + z * z;
+	}
+};
+
+struct entity {
+	std::string name;
+	vec3 position;
+	int health = 100;
+
+	void damage(int amount) {
+		health -= amount;
+	}
+};
+
+struct handle {
+	int id = 0;
+};
+
+int main() {
+	sol::footprint_report report;
+
+	report.add_usertype<handle>(handle());
+	report.add_usertype<vec3>([](sol::state& lua) {
+		lua.new_usertype<vec3>("vec3",
+			"x", &vec3::x,
+			"y", &vec3::y,
+			"z", &vec3::z,
+			"length_squared", &vec3::length_squared
+		);
+	}, vec3());
+	report.add_usertype<entity>([](sol::state& lua) {
+		lua.new_simple_usertype<entity>("entity",
+			"name", &entity::name,
+			"health", &entity::health,
+			"damage", &entity::damage
+		);
+	}, entity());
+
+	int total = 0;
+	report.add_closure("capture int&", [&total](int x) { total += x; });
+	std::shared_ptr<entity> target = std::make_shared<entity>();
+	report.add_closure("capture shared_ptr", [target](int x) { target->damage(x); });
+
+	report.write_table(std::cout);
+	std::cout << std::endl;
+}
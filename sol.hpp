@@ -29,5 +29,7 @@
 #include "sol/state.hpp"
 #include "sol/coroutine.hpp"
 #include "sol/variadic_args.hpp"
+#include "sol/profiler.hpp"
+#include "sol/memory_footprint.hpp"
 
 #endif // SOL_HPP
@@ -0,0 +1,280 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2016 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_ACCOUNTING_ALLOCATOR_HPP
+#define SOL_ACCOUNTING_ALLOCATOR_HPP
+
+#include "compatibility.hpp"
+#include "hot_path_counters.hpp"
+#include "heap_profiler.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <map>
+#include <unordered_map>
+
+namespace sol {
+	struct memory_usage {
+		std::size_t live_bytes = 0;
+		std::size_t peak_bytes = 0;
+		std::size_t allocations = 0;
+	};
+
+	struct memory_stats {
+		memory_usage total;
+		memory_usage tables;
+		memory_usage strings;
+		memory_usage functions;
+		memory_usage userdata;
+		memory_usage threads;
+		memory_usage other;
+		// a breakdown of userdata, keyed by the metatable name
+		// of the usertype (usertype_traits<T>::get_metatable())
+		std::map<std::string, memory_usage> usertypes;
+		std::size_t budget = 0;
+		std::size_t failed_allocations = 0;
+	};
+
+	// A lua_Alloc that keeps track of what the state it is given to allocates
+	// Hand it to a state with sol::state(allocator) or lua_newstate(&accounting_allocator::allocate, &allocator):
+	// it must outlive the state, and must not be shared between states running on different threads
+	class accounting_allocator {
+	private:
+		enum category_index {
+			tables,
+			strings,
+			functions,
+			userdata,
+			threads,
+			other,
+			category_count
+		};
+
+		struct usertype_usage {
+			std::string name;
+			memory_usage usage;
+		};
+
+		// every block carries which buckets it was counted in,
+		// since Lua does not tell us the type of a block when it frees it
+		union header {
+			struct {
+				memory_usage* category;
+				memory_usage* usertype;
+			} owner;
+			std::max_align_t alignment;
+		};
+
+		memory_usage total;
+		memory_usage categories[category_count];
+		std::unordered_map<const void*, usertype_usage> usertypes;
+		memory_usage* pending_usertype;
+		std::size_t limit;
+		std::size_t failures;
+
+		static void add(memory_usage& usage, std::size_t size) {
+			usage.live_bytes += size;
+			if (usage.live_bytes > usage.peak_bytes) {
+				usage.peak_bytes = usage.live_bytes;
+			}
+		}
+
+		static void remove(memory_usage& usage, std::size_t size) {
+			usage.live_bytes -= size;
+		}
+
+		static void resize(memory_usage* usage, std::size_t osize, std::size_t nsize) {
+			if (usage == nullptr) {
+				return;
+			}
+			remove(*usage, osize);
+			add(*usage, nsize);
+		}
+
+		memory_usage& category_of(std::size_t luatype) {
+#if SOL_LUA_VERSION >= 502
+			// for new objects, 5.2+ passes the object's type tag (plus variant bits) as the old size
+			switch (luatype & 0x0F) {
+			case LUA_TTABLE:
+				return categories[tables];
+			case LUA_TSTRING:
+				return categories[strings];
+			case LUA_TFUNCTION:
+			case 9:
+			case 10:
+				// closures, plus the internal prototype and upvalue tags that follow the public types
+				return categories[functions];
+			case LUA_TUSERDATA:
+				return categories[userdata];
+			case LUA_TTHREAD:
+				return categories[threads];
+			default:
+				break;
+			}
+#else
+			(void)luatype;
+#endif // Lua 5.2+ passes object types
+			return categories[other];
+		}
+
+		bool over_budget(std::size_t growth) const {
+			return limit != 0 && (growth > limit || total.live_bytes > limit - growth);
+		}
+
+		void* allocate_new(std::size_t luatype, std::size_t nsize) {
+			memory_usage& category = category_of(luatype);
+			memory_usage* usertype = nullptr;
+			if (pending_usertype != nullptr && (&category == &categories[userdata] || SOL_LUA_VERSION < 502)) {
+				usertype = pending_usertype;
+				pending_usertype = nullptr;
+			}
+			if (over_budget(nsize)) {
+				++failures;
+				return nullptr;
+			}
+			header* h = static_cast<header*>(std::malloc(sizeof(header) + nsize));
+			if (h == nullptr) {
+				++failures;
+				return nullptr;
+			}
+			h->owner.category = &category;
+			h->owner.usertype = usertype;
+			add(total, nsize);
+			++total.allocations;
+			add(category, nsize);
+			++category.allocations;
+			if (usertype != nullptr) {
+				add(*usertype, nsize);
+				++usertype->allocations;
+			}
+			return static_cast<void*>(h + 1);
+		}
+
+		void* reallocate(void* ptr, std::size_t osize, std::size_t nsize) {
+			header* h = static_cast<header*>(ptr) - 1;
+			if (nsize > osize && over_budget(nsize - osize)) {
+				++failures;
+				return nullptr;
+			}
+			header* nh = static_cast<header*>(std::realloc(h, sizeof(header) + nsize));
+			if (nh == nullptr) {
+				++failures;
+				return nullptr;
+			}
+			resize(&total, osize, nsize);
+			resize(nh->owner.category, osize, nsize);
+			resize(nh->owner.usertype, osize, nsize);
+			return static_cast<void*>(nh + 1);
+		}
+
+		void deallocate(void* ptr, std::size_t osize) {
+			header* h = static_cast<header*>(ptr) - 1;
+			remove(total, osize);
+			remove(*h->owner.category, osize);
+			if (h->owner.usertype != nullptr) {
+				remove(*h->owner.usertype, osize);
+			}
+			std::free(h);
+		}
+
+	public:
+		accounting_allocator(std::size_t budget = 0) : pending_usertype(nullptr), limit(budget), failures(0) {}
+
+		accounting_allocator(const accounting_allocator&) = delete;
+		accounting_allocator& operator=(const accounting_allocator&) = delete;
+
+		static void* allocate(void* ud, void* ptr, std::size_t osize, std::size_t nsize) {
+			accounting_allocator& self = *static_cast<accounting_allocator*>(ud);
+			if (nsize == 0) {
+				if (ptr != nullptr) {
+					self.deallocate(ptr, osize);
+				}
+				return nullptr;
+			}
+			if (ptr == nullptr) {
+				return self.allocate_new(osize, nsize);
+			}
+			return self.reallocate(ptr, osize, nsize);
+		}
+
+		// Returns the allocator a state was created with, or nullptr if it is not an accounting_allocator
+		static accounting_allocator* from(lua_State* L) {
+			void* ud = nullptr;
+			lua_Alloc f = lua_getallocf(L, &ud);
+			return f == &allocate ? static_cast<accounting_allocator*>(ud) : nullptr;
+		}
+
+		// Attributes the next userdata allocation to the usertype with the given metatable name
+		void tag_next_userdata(const std::string& metakey) {
+			auto it = usertypes.find(&metakey);
+			if (it == usertypes.end()) {
+				it = usertypes.emplace(&metakey, usertype_usage{ metakey, memory_usage() }).first;
+			}
+			pending_usertype = &it->second.usage;
+		}
+
+		// 0 means no budget: allocations only fail when malloc does
+		void set_budget(std::size_t budget) {
+			limit = budget;
+		}
+
+		std::size_t budget() const {
+			return limit;
+		}
+
+		std::size_t live_bytes() const {
+			return total.live_bytes;
+		}
+
+		memory_stats stats() const {
+			memory_stats s;
+			s.total = total;
+			s.tables = categories[tables];
+			s.strings = categories[strings];
+			s.functions = categories[functions];
+			s.userdata = categories[userdata];
+			s.threads = categories[threads];
+			s.other = categories[other];
+			for (const auto& kvp : usertypes) {
+				s.usertypes[kvp.second.name] = kvp.second.usage;
+			}
+			s.budget = limit;
+			s.failed_allocations = failures;
+			return s;
+		}
+	};
+
+	namespace detail {
+		// lua_newuserdata, attributing the block to the usertype
+		// whose metatable it is about to receive
+		inline void* usertype_newuserdata(lua_State* L, std::size_t size, const std::string& metakey) {
+			count_hot_path(L, &hot_path_counters::new_userdata);
+			accounting_allocator* allocator = accounting_allocator::from(L);
+			if (allocator != nullptr) {
+				allocator->tag_next_userdata(metakey);
+			}
+			heap_origin_scope origin(L, "sol: usertype userdata");
+			return lua_newuserdata(L, size);
+		}
+	} // detail
+} // sol
+
+#endif // SOL_ACCOUNTING_ALLOCATOR_HPP
@@ -0,0 +1,233 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2016 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_BINDING_STATS_HPP
+#define SOL_BINDING_STATS_HPP
+
+#include "compatibility.hpp"
+#include <chrono>
+#include <string>
+#include <map>
+#ifdef SOL_BINDING_STATS
+#include <unordered_map>
+#include <new>
+#endif // Binding Statistics
+
+namespace sol {
+	struct binding_stat {
+		std::size_t calls = 0;
+		std::size_t argument_failures = 0;
+		std::chrono::nanoseconds total_time = std::chrono::nanoseconds::zero();
+		std::chrono::nanoseconds max_time = std::chrono::nanoseconds::zero();
+	};
+
+	typedef std::map<std::string, binding_stat> binding_stats_table;
+
+	namespace detail {
+#ifdef SOL_BINDING_STATS
+		struct binding_stats_storage;
+
+		struct binding_record {
+			binding_stat stat;
+			binding_stats_storage* storage = nullptr;
+			// the binding that was running when this one was entered,
+			// used to recover attribution when an argument check longjmps out
+			binding_record* caller = nullptr;
+		};
+
+		struct binding_stats_storage {
+			// node-based: records never move, so bindings can hold on to them
+			std::unordered_map<std::string, binding_record> records;
+			binding_record* current = nullptr;
+		};
+
+		inline const void* binding_stats_key() {
+			static const char key = 0;
+			return &key;
+		}
+
+		inline int binding_stats_destroy(lua_State* L) {
+			binding_stats_storage* storage = static_cast<binding_stats_storage*>(lua_touserdata(L, 1));
+			storage->~binding_stats_storage();
+			return 0;
+		}
+
+		inline binding_stats_storage* find_binding_stats(lua_State* L) {
+			lua_rawgetp(L, LUA_REGISTRYINDEX, binding_stats_key());
+			binding_stats_storage* storage = static_cast<binding_stats_storage*>(lua_touserdata(L, -1));
+			lua_pop(L, 1);
+			return storage;
+		}
+
+		inline binding_stats_storage& ensure_binding_stats(lua_State* L) {
+			binding_stats_storage* storage = find_binding_stats(L);
+			if (storage != nullptr) {
+				return *storage;
+			}
+			storage = new (lua_newuserdata(L, sizeof(binding_stats_storage))) binding_stats_storage();
+			lua_createtable(L, 0, 1);
+			lua_pushcclosure(L, &binding_stats_destroy, 0);
+			lua_setfield(L, -2, "__gc");
+			lua_setmetatable(L, -2);
+			lua_rawsetp(L, LUA_REGISTRYINDEX, binding_stats_key());
+			return *storage;
+		}
+
+		inline binding_record* register_binding(lua_State* L, const std::string& name) {
+			binding_stats_storage& storage = ensure_binding_stats(L);
+			binding_record& record = storage.records[name];
+			record.storage = &storage;
+			return &record;
+		}
+
+		class binding_scope {
+		private:
+			typedef std::chrono::steady_clock clock;
+			binding_record* record;
+			binding_record* previous;
+			clock::time_point start;
+
+		public:
+			binding_scope(binding_record* record) : record(record), previous(nullptr) {
+				if (record == nullptr) {
+					return;
+				}
+				++record->stat.calls;
+				previous = record->storage->current;
+				record->caller = previous;
+				record->storage->current = record;
+				start = clock::now();
+			}
+
+			binding_scope(const binding_scope&) = delete;
+			binding_scope& operator=(const binding_scope&) = delete;
+
+			~binding_scope() {
+				if (record == nullptr) {
+					return;
+				}
+				std::chrono::nanoseconds elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+				record->stat.total_time += elapsed;
+				if (elapsed > record->stat.max_time) {
+					record->stat.max_time = elapsed;
+				}
+				record->storage->current = previous;
+			}
+		};
+
+		// Closure used to time bindings whose call path is not sol's own:
+		// upvalue 1 is the real function, upvalue 2 is its binding_record
+		// The call is protected so that an error closes the scope before it is
+		// raised again; otherwise it would longjmp past ~binding_scope
+		inline int binding_stats_call(lua_State* L) {
+			binding_record* record = static_cast<binding_record*>(lua_touserdata(L, lua_upvalueindex(2)));
+			int status;
+			{
+				binding_scope scope(record);
+				int argcount = lua_gettop(L);
+				lua_pushvalue(L, lua_upvalueindex(1));
+				lua_insert(L, 1);
+				status = lua_pcall(L, argcount, LUA_MULTRET, 0);
+			}
+			if (status != LUA_OK) {
+				return lua_error(L);
+			}
+			return lua_gettop(L);
+		}
+
+		// Replaces the function on top of the stack with a timed closure around it
+		inline void instrument_binding(lua_State* L, const std::string& name) {
+			if (lua_type(L, -1) != LUA_TFUNCTION) {
+				return;
+			}
+			binding_record* record = register_binding(L, name);
+			lua_pushlightuserdata(L, static_cast<void*>(record));
+			lua_pushcclosure(L, &binding_stats_call, 2);
+		}
+
+		inline void binding_argument_failure(lua_State* L) {
+			binding_stats_storage* storage = find_binding_stats(L);
+			if (storage == nullptr || storage->current == nullptr) {
+				return;
+			}
+			binding_record* record = storage->current;
+			++record->stat.argument_failures;
+			// the error is about to longjmp past the binding's scope
+			storage->current = record->caller;
+		}
+#else
+		inline void instrument_binding(lua_State*, const std::string&) {}
+
+		inline void binding_argument_failure(lua_State*) {}
+#endif // Binding Statistics
+	} // detail
+
+	inline binding_stats_table binding_stats(lua_State* L) {
+		binding_stats_table stats;
+#ifdef SOL_BINDING_STATS
+		detail::binding_stats_storage* storage = detail::find_binding_stats(L);
+		if (storage != nullptr) {
+			for (const auto& kvp : storage->records) {
+				stats.emplace(kvp.first, kvp.second.stat);
+			}
+		}
+#else
+		(void)L;
+#endif // Binding Statistics
+		return stats;
+	}
+
+	inline void reset_binding_stats(lua_State* L) {
+#ifdef SOL_BINDING_STATS
+		// zero out instead of erasing: bindings keep pointers to their records
+		detail::binding_stats_storage* storage = detail::find_binding_stats(L);
+		if (storage != nullptr) {
+			for (auto& kvp : storage->records) {
+				kvp.second.stat = binding_stat();
+			}
+		}
+#else
+		(void)L;
+#endif // Binding Statistics
+	}
+
+	// lua_CFunction that returns the statistics as a table of
+	// name -> { calls, argument_failures, total_time, max_time } (times in nanoseconds)
+	inline int lua_binding_stats(lua_State* L) {
+		binding_stats_table stats = binding_stats(L);
+		lua_createtable(L, 0, static_cast<int>(stats.size()));
+		for (const auto& kvp : stats) {
+			lua_createtable(L, 0, 4);
+			lua_pushinteger(L, static_cast<lua_Integer>(kvp.second.calls));
+			lua_setfield(L, -2, "calls");
+			lua_pushinteger(L, static_cast<lua_Integer>(kvp.second.argument_failures));
+			lua_setfield(L, -2, "argument_failures");
+			lua_pushinteger(L, static_cast<lua_Integer>(kvp.second.total_time.count()));
+			lua_setfield(L, -2, "total_time");
+			lua_pushinteger(L, static_cast<lua_Integer>(kvp.second.max_time.count()));
+			lua_setfield(L, -2, "max_time");
+			lua_setfield(L, -2, kvp.first.c_str());
+		}
+		return 1;
+	}
+} // sol
+
+#endif // SOL_BINDING_STATS_HPP
@@ -0,0 +1,300 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2016 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_CALL_LATENCY_HPP
+#define SOL_CALL_LATENCY_HPP
+
+#include "compatibility.hpp"
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <map>
+#include <utility>
+#include <vector>
+#ifdef SOL_CALL_LATENCY
+#include <unordered_map>
+#include <new>
+#endif // Call Latency
+
+namespace sol {
+	// Log-linear buckets in the style of HdrHistogram: every power of two
+	// of nanoseconds is split into 8 buckets, so any recorded value is
+	// known to within 12.5% while the whole histogram stays a fixed size
+	class latency_histogram {
+	private:
+		static const std::size_t sub_bucket_bits = 3;
+		static const std::size_t sub_buckets = std::size_t(1) << sub_bucket_bits;
+		static const std::size_t bucket_count = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+		std::array<std::uint64_t, bucket_count> counts;
+		std::uint64_t total;
+		std::uint64_t smallest;
+		std::uint64_t largest;
+		std::uint64_t sum;
+
+		static std::size_t index_of(std::uint64_t value) {
+			if (value < sub_buckets) {
+				return static_cast<std::size_t>(value);
+			}
+			std::size_t magnitude = 0;
+			for (std::uint64_t v = value; v >= sub_buckets * 2; v >>= 1) {
+				++magnitude;
+			}
+			// value >> magnitude is in [sub_buckets, sub_buckets * 2)
+			return (magnitude + 1) * sub_buckets + static_cast<std::size_t>((value >> magnitude) - sub_buckets);
+		}
+
+		// the largest value that lands in the bucket
+		static std::uint64_t upper_bound_of(std::size_t index) {
+			if (index < sub_buckets) {
+				return index;
+			}
+			std::size_t magnitude = index / sub_buckets - 1;
+			std::uint64_t lowest = (static_cast<std::uint64_t>(index % sub_buckets) + sub_buckets) << magnitude;
+			return lowest + ((std::uint64_t(1) << magnitude) - 1);
+		}
+
+	public:
+		latency_histogram() {
+			reset();
+		}
+
+		void record(std::chrono::nanoseconds elapsed) {
+			std::uint64_t value = elapsed.count() < 0 ? 0 : static_cast<std::uint64_t>(elapsed.count());
+			++counts[index_of(value)];
+			++total;
+			sum += value;
+			smallest = (std::min)(smallest, value);
+			largest = (std::max)(largest, value);
+		}
+
+		void reset() {
+			counts.fill(0);
+			total = 0;
+			smallest = (std::numeric_limits<std::uint64_t>::max)();
+			largest = 0;
+			sum = 0;
+		}
+
+		std::uint64_t count() const {
+			return total;
+		}
+
+		std::chrono::nanoseconds min() const {
+			return std::chrono::nanoseconds(total == 0 ? 0 : smallest);
+		}
+
+		std::chrono::nanoseconds max() const {
+			return std::chrono::nanoseconds(largest);
+		}
+
+		std::chrono::nanoseconds mean() const {
+			return std::chrono::nanoseconds(total == 0 ? 0 : sum / total);
+		}
+
+		// The smallest bucket bound that at least fraction (0 to 1) of the calls fit under,
+		// clamped to the largest value actually seen
+		std::chrono::nanoseconds percentile(double fraction) const {
+			if (total == 0) {
+				return std::chrono::nanoseconds::zero();
+			}
+			double wanted = fraction * static_cast<double>(total);
+			std::uint64_t seen = 0;
+			for (std::size_t i = 0; i < bucket_count; ++i) {
+				seen += counts[i];
+				if (seen > 0 && static_cast<double>(seen) >= wanted) {
+					return std::chrono::nanoseconds((std::min)(upper_bound_of(i), largest));
+				}
+			}
+			return max();
+		}
+
+		// Every non-empty bucket as (largest value in the bucket, count), in increasing order
+		std::vector<std::pair<std::chrono::nanoseconds, std::uint64_t>> buckets() const {
+			std::vector<std::pair<std::chrono::nanoseconds, std::uint64_t>> r;
+			for (std::size_t i = 0; i < bucket_count; ++i) {
+				if (counts[i] != 0) {
+					r.emplace_back(std::chrono::nanoseconds(upper_bound_of(i)), counts[i]);
+				}
+			}
+			return r;
+		}
+	};
+
+	typedef std::map<std::string, latency_histogram> call_latency_table;
+
+	namespace detail {
+#ifdef SOL_CALL_LATENCY
+		struct latency_record {
+			latency_histogram histogram;
+		};
+
+		struct call_latency_storage {
+			// node-based: records never move, so functions can hold on to them
+			std::unordered_map<std::string, latency_record> records;
+		};
+
+		inline const void* call_latency_key() {
+			static const char key = 0;
+			return &key;
+		}
+
+		inline int call_latency_destroy(lua_State* L) {
+			call_latency_storage* storage = static_cast<call_latency_storage*>(lua_touserdata(L, 1));
+			storage->~call_latency_storage();
+			return 0;
+		}
+
+		inline call_latency_storage* find_call_latency(lua_State* L) {
+			lua_rawgetp(L, LUA_REGISTRYINDEX, call_latency_key());
+			call_latency_storage* storage = static_cast<call_latency_storage*>(lua_touserdata(L, -1));
+			lua_pop(L, 1);
+			return storage;
+		}
+
+		inline call_latency_storage& ensure_call_latency(lua_State* L) {
+			call_latency_storage* storage = find_call_latency(L);
+			if (storage != nullptr) {
+				return *storage;
+			}
+			storage = new (lua_newuserdata(L, sizeof(call_latency_storage))) call_latency_storage();
+			lua_createtable(L, 0, 1);
+			lua_pushcclosure(L, &call_latency_destroy, 0);
+			lua_setfield(L, -2, "__gc");
+			lua_setmetatable(L, -2);
+			lua_rawsetp(L, LUA_REGISTRYINDEX, call_latency_key());
+			return *storage;
+		}
+
+		inline latency_record* register_latency(lua_State* L, const std::string& name) {
+			return &ensure_call_latency(L).records[name];
+		}
+
+		// Functions nobody named are recorded under where they were defined,
+		// "source:line" for Lua functions and "[C]" for C functions
+		inline latency_record* register_latency(lua_State* L, int index) {
+			lua_Debug ar;
+			lua_pushvalue(L, index);
+			lua_getinfo(L, ">S", &ar);
+			std::string name = ar.short_src;
+			if (ar.linedefined > 0) {
+				name += ":";
+				name += std::to_string(ar.linedefined);
+			}
+			return register_latency(L, name);
+		}
+
+		// Times a C++-to-Lua call from before the error handler and arguments are
+		// pushed until after the results are extracted: it has to be the first local
+		// in call(), so that it is destroyed after the return value is built
+		class latency_scope {
+		private:
+			typedef std::chrono::steady_clock clock;
+			latency_record* record;
+			clock::time_point start;
+
+		public:
+			template <typename Fx>
+			latency_scope(const Fx& fx, latency_record*& cached) {
+				if (cached == nullptr) {
+					lua_State* L = fx.lua_state();
+					fx.push();
+					cached = register_latency(L, -1);
+					lua_pop(L, 1);
+				}
+				record = cached;
+				start = clock::now();
+			}
+
+			latency_scope(const latency_scope&) = delete;
+			latency_scope& operator=(const latency_scope&) = delete;
+
+			~latency_scope() {
+				record->histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start));
+			}
+		};
+#else
+		struct latency_record;
+#endif // Call Latency
+	} // detail
+
+	inline call_latency_table call_latencies(lua_State* L) {
+		call_latency_table latencies;
+#ifdef SOL_CALL_LATENCY
+		detail::call_latency_storage* storage = detail::find_call_latency(L);
+		if (storage != nullptr) {
+			for (const auto& kvp : storage->records) {
+				latencies.emplace(kvp.first, kvp.second.histogram);
+			}
+		}
+#else
+		(void)L;
+#endif // Call Latency
+		return latencies;
+	}
+
+	inline void reset_call_latencies(lua_State* L) {
+#ifdef SOL_CALL_LATENCY
+		// clear instead of erasing: functions keep pointers to their records
+		detail::call_latency_storage* storage = detail::find_call_latency(L);
+		if (storage != nullptr) {
+			for (auto& kvp : storage->records) {
+				kvp.second.histogram.reset();
+			}
+		}
+#else
+		(void)L;
+#endif // Call Latency
+	}
+
+	// lua_CFunction that returns the histograms as a table of
+	// name -> { count, min, mean, p50, p90, p99, p999, max } (times in nanoseconds)
+	inline int lua_call_latencies(lua_State* L) {
+		call_latency_table latencies = call_latencies(L);
+		lua_createtable(L, 0, static_cast<int>(latencies.size()));
+		for (const auto& kvp : latencies) {
+			const latency_histogram& h = kvp.second;
+			const std::pair<const char*, std::chrono::nanoseconds> fields[] = {
+				{ "min", h.min() },
+				{ "mean", h.mean() },
+				{ "p50", h.percentile(0.5) },
+				{ "p90", h.percentile(0.9) },
+				{ "p99", h.percentile(0.99) },
+				{ "p999", h.percentile(0.999) },
+				{ "max", h.max() }
+			};
+			lua_createtable(L, 0, 8);
+			lua_pushinteger(L, static_cast<lua_Integer>(h.count()));
+			lua_setfield(L, -2, "count");
+			for (const auto& field : fields) {
+				lua_pushinteger(L, static_cast<lua_Integer>(field.second.count()));
+				lua_setfield(L, -2, field.first);
+			}
+			lua_setfield(L, -2, kvp.first.c_str());
+		}
+		return 1;
+	}
+} // sol
+
+#endif // SOL_CALL_LATENCY_HPP
@@ -0,0 +1,531 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2016 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_CONTAINER_USERTYPE_HPP
+#define SOL_CONTAINER_USERTYPE_HPP
+
+#include "stack.hpp"
+#include "usertype_metatable.hpp"
+#include <iterator>
+
+namespace sol {
+
+	// Pushes a container as a userdata that works on it in place, instead of
+	// copying it into a new table: a view for lvalues, which must outlive the
+	// Lua side, or an owned copy for rvalues, which are moved in
+	template <typename T>
+	struct as_container_t {
+		T source;
+
+		as_container_t(T value) : source(std::forward<T>(value)) {}
+	};
+
+	template <typename T>
+	inline as_container_t<T> as_container(T&& value) {
+		return as_container_t<T>(std::forward<T>(value));
+	}
+
+	namespace container_detail {
+		struct has_push_back_impl {
+			template <typename T, typename U = meta::unqualified_t<T>,
+				typename P = decltype(std::declval<U&>().push_back(std::declval<typename U::value_type>()))>
+			static std::true_type test(int);
+
+			template <typename...>
+			static std::false_type test(...);
+		};
+
+		template <typename T>
+		struct has_push_back : decltype(has_push_back_impl::test<T>(0)) {};
+
+		struct has_insert_erase_impl {
+			template <typename T, typename U = meta::unqualified_t<T>,
+				typename I = decltype(std::declval<U&>().insert(std::declval<U&>().begin(), std::declval<typename U::value_type>())),
+				typename E = decltype(std::declval<U&>().erase(std::declval<U&>().begin()))>
+			static std::true_type test(int);
+
+			template <typename...>
+			static std::false_type test(...);
+		};
+
+		template <typename T>
+		struct has_insert_erase : decltype(has_insert_erase_impl::test<T>(0)) {};
+
+		struct has_clear_impl {
+			template <typename T, typename U = meta::unqualified_t<T>,
+				typename C = decltype(std::declval<U&>().clear())>
+			static std::true_type test(int);
+
+			template <typename...>
+			static std::false_type test(...);
+		};
+
+		template <typename T>
+		struct has_clear : decltype(has_clear_impl::test<T>(0)) {};
+
+		struct has_size_impl {
+			template <typename T, typename U = meta::unqualified_t<T>,
+				typename S = decltype(std::declval<const U&>().size())>
+			static std::true_type test(int);
+
+			template <typename...>
+			static std::false_type test(...);
+		};
+
+		template <typename T>
+		struct has_size : decltype(has_size_impl::test<T>(0)) {};
+
+		struct is_map_impl {
+			template <typename T, typename U = meta::unqualified_t<T>,
+				typename K = typename U::key_type,
+				typename M = typename U::mapped_type>
+			static std::true_type test(int);
+
+			template <typename...>
+			static std::false_type test(...);
+		};
+
+		template <typename T>
+		struct is_map : meta::all<meta::has_key_value_pair<T>, decltype(is_map_impl::test<T>(0))> {};
+
+		// Sequences are indexed by position, from 1, and maps by key.
+		// Elements that are usertypes are pushed as references into the container
+		// Only random access sequences can be indexed: the others are walked
+		// with an iterator kept by pairs, so they are never searched from the start
+		template <typename C>
+		struct container_usertype_metatable {
+			typedef container_detail::is_map<C> is_associative;
+			typedef typename C::value_type value_type;
+			typedef decltype(std::declval<C&>().begin()) iterator;
+			typedef std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<iterator>::iterator_category> is_random_access;
+
+			static C& source(lua_State* L) {
+				void* ud = lua_type(L, 1) == LUA_TUSERDATA ? lua_touserdata(L, 1) : nullptr;
+				if (ud == nullptr) {
+					luaL_error(L, "sol: container function called without its container (use ':' rather than '.')");
+				}
+				return **static_cast<C**>(ud);
+			}
+
+			static std::size_t size_of(const C& c, std::true_type) {
+				return static_cast<std::size_t>(c.size());
+			}
+
+			static std::size_t size_of(const C& c, std::false_type) {
+				return static_cast<std::size_t>(std::distance(c.begin(), c.end()));
+			}
+
+			static std::size_t size_of(const C& c) {
+				return size_of(c, has_size<C>());
+			}
+
+			static int method(lua_State* L) {
+				lua_pushvalue(L, 2);
+				lua_rawget(L, upvalue_index(1));
+				return 1;
+			}
+
+			template <typename E>
+			static int assign(lua_State* L, E& element, int index, std::true_type) {
+				element = stack::get<std::remove_const_t<E>>(L, index);
+				return 0;
+			}
+
+			template <typename E>
+			static int assign(lua_State* L, E&, int, std::false_type) {
+				return luaL_error(L, "sol: the elements of this container cannot be assigned to");
+			}
+
+			template <typename E>
+			static int assign(lua_State* L, E& element, int index) {
+				return assign(L, element, index, std::is_assignable<E&, std::remove_const_t<E>>());
+			}
+
+			static int add_back(lua_State* L, C& c, int index, std::true_type) {
+				c.push_back(stack::get<value_type>(L, index));
+				return 0;
+			}
+
+			static int add_back(lua_State* L, C&, int, std::false_type) {
+				return luaL_error(L, "sol: elements cannot be added to this container");
+			}
+
+			// Leaves 0-based index of a whole number key in pos,
+			// if it is an existing position or, with end, one past the last
+			static bool position(lua_State* L, const C& c, int key, bool end, std::size_t& pos) {
+				if (!usertype_detail::is_integer_key(L, key)) {
+					return false;
+				}
+				lua_Integer i = lua_tointeger(L, key);
+				std::size_t n = size_of(c);
+				if (i < 1 || static_cast<std::size_t>(i) > n + (end ? 1 : 0)) {
+					return false;
+				}
+				pos = static_cast<std::size_t>(i - 1);
+				return true;
+			}
+
+			static int index(lua_State* L, C& c, std::false_type) {
+				return index_at(L, c, is_random_access());
+			}
+
+			static int index_at(lua_State* L, C& c, std::true_type) {
+				std::size_t pos;
+				if (position(L, c, 2, false, pos)) {
+					return stack::push_reference(L, *std::next(c.begin(), pos));
+				}
+				return method(L);
+			}
+
+			static int index_at(lua_State* L, C&, std::false_type) {
+				if (usertype_detail::is_integer_key(L, 2)) {
+					return luaL_error(L, "sol: only containers with random access can be indexed by position (use pairs)");
+				}
+				return method(L);
+			}
+
+			static int index(lua_State* L, C& c, std::true_type) {
+				auto key = stack::check_get<typename C::key_type>(L, 2);
+				if (key) {
+					auto it = c.find(*key);
+					if (it != c.end()) {
+						return stack::push_reference(L, it->second);
+					}
+				}
+				return method(L);
+			}
+
+			static int new_index(lua_State* L, C& c, std::false_type) {
+				std::size_t pos;
+				if (!position(L, c, 2, true, pos)) {
+					return luaL_error(L, "sol: containers can only be set at positions from 1 to one past their size");
+				}
+				if (pos == size_of(c)) {
+					return add_back(L, c, 3, has_push_back<C>());
+				}
+				return assign_at(L, c, pos, is_random_access());
+			}
+
+			static int assign_at(lua_State* L, C& c, std::size_t pos, std::true_type) {
+				return assign(L, *std::next(c.begin(), pos), 3);
+			}
+
+			static int assign_at(lua_State* L, C&, std::size_t, std::false_type) {
+				return luaL_error(L, "sol: only containers with random access can be assigned to by position");
+			}
+
+			static int new_index(lua_State* L, C& c, std::true_type) {
+				auto key = stack::get<typename C::key_type>(L, 2);
+				if (lua_isnil(L, 3)) {
+					c.erase(key);
+					return 0;
+				}
+				auto it = c.find(key);
+				if (it == c.end()) {
+					c.emplace(std::move(key), stack::get<typename C::mapped_type>(L, 3));
+					return 0;
+				}
+				return assign(L, it->second, 3);
+			}
+
+			static int next(lua_State* L, C& c, std::false_type) {
+				std::size_t pos = lua_isnil(L, 2) ? 0 : static_cast<std::size_t>(lua_tointeger(L, 2));
+				if (pos >= size_of(c)) {
+					lua_pushnil(L);
+					return 1;
+				}
+				stack::push(L, pos + 1);
+				stack::push_reference(L, *std::next(c.begin(), pos));
+				return 2;
+			}
+
+			static int next(lua_State* L, C& c, std::true_type) {
+				auto it = c.begin();
+				if (!lua_isnil(L, 2)) {
+					it = c.find(stack::get<typename C::key_type>(L, 2));
+					if (it != c.end()) {
+						++it;
+					}
+				}
+				if (it == c.end()) {
+					lua_pushnil(L);
+					return 1;
+				}
+				stack::push_reference(L, it->first);
+				stack::push_reference(L, it->second);
+				return 2;
+			}
+
+			static int insert(lua_State* L, C& c, std::false_type) {
+				return insert_at(L, c, has_insert_erase<C>());
+			}
+
+			static int insert(lua_State* L, C& c, std::true_type) {
+				lua_settop(L, 3);
+				return new_index(L, c, is_associative());
+			}
+
+			static int insert_at(lua_State* L, C& c, std::true_type) {
+				std::size_t pos;
+				if (!position(L, c, 2, true, pos)) {
+					return luaL_error(L, "sol: containers can only be inserted into at positions from 1 to one past their size");
+				}
+				c.insert(std::next(c.begin(), pos), stack::get<value_type>(L, 3));
+				return 0;
+			}
+
+			static int insert_at(lua_State* L, C&, std::false_type) {
+				return luaL_error(L, "sol: elements cannot be inserted into this container");
+			}
+
+			static int erase(lua_State* L, C& c, std::false_type) {
+				return erase_at(L, c, has_insert_erase<C>());
+			}
+
+			static int erase(lua_State* L, C& c, std::true_type) {
+				c.erase(stack::get<typename C::key_type>(L, 2));
+				return 0;
+			}
+
+			static int erase_at(lua_State* L, C& c, std::true_type) {
+				std::size_t pos;
+				if (position(L, c, 2, false, pos)) {
+					c.erase(std::next(c.begin(), pos));
+				}
+				return 0;
+			}
+
+			static int erase_at(lua_State* L, C&, std::false_type) {
+				return luaL_error(L, "sol: elements cannot be erased from this container");
+			}
+
+			static int clear(lua_State*, C& c, std::true_type) {
+				c.clear();
+				return 0;
+			}
+
+			static int clear(lua_State* L, C&, std::false_type) {
+				return luaL_error(L, "sol: this container cannot be cleared");
+			}
+
+			static int real_index_call(lua_State* L) {
+				return index(L, source(L), is_associative());
+			}
+
+			static int real_new_index_call(lua_State* L) {
+				return new_index(L, source(L), is_associative());
+			}
+
+			static int real_length_call(lua_State* L) {
+				return stack::push(L, size_of(source(L)));
+			}
+
+			static int real_next_call(lua_State* L) {
+				return next(L, source(L), is_associative());
+			}
+
+			static int real_walk_call(lua_State* L) {
+				C& c = source(L);
+				iterator& it = *static_cast<iterator*>(lua_touserdata(L, upvalue_index(1)));
+				if (it == c.end()) {
+					lua_pushnil(L);
+					return 1;
+				}
+				lua_Integer i = lua_isnil(L, 2) ? 1 : lua_tointeger(L, 2) + 1;
+				stack::push(L, i);
+				stack::push_reference(L, *it);
+				++it;
+				return 2;
+			}
+
+			// Keys or positions are found again on each step
+			static int pairs(lua_State* L, C&, std::true_type) {
+				lua_pushcclosure(L, &next_call, 0);
+				lua_pushvalue(L, 1);
+				lua_pushnil(L);
+				return 3;
+			}
+
+			// The closure keeps the iterator: the container must not be
+			// changed while it is walked
+			static int pairs(lua_State* L, C& c, std::false_type) {
+				static_assert(std::is_trivially_destructible<iterator>::value, "the iterator of a container is kept in a userdata without a __gc");
+				void* it = lua_newuserdata(L, sizeof(iterator));
+				new (it) iterator(c.begin());
+				lua_pushcclosure(L, &walk_call, 1);
+				lua_pushvalue(L, 1);
+				lua_pushnil(L);
+				return 3;
+			}
+
+			static int real_pairs_call(lua_State* L) {
+				return pairs(L, source(L), meta::any<is_associative, is_random_access>());
+			}
+
+			static int real_add_call(lua_State* L) {
+				C& c = source(L);
+				if (is_associative::value) {
+					return insert(L, c, is_associative());
+				}
+				return add_back(L, c, 2, has_push_back<C>());
+			}
+
+			static int real_insert_call(lua_State* L) {
+				return insert(L, source(L), is_associative());
+			}
+
+			static int real_erase_call(lua_State* L) {
+				return erase(L, source(L), is_associative());
+			}
+
+			static int real_clear_call(lua_State* L) {
+				return clear(L, source(L), has_clear<C>());
+			}
+
+			static int real_destruct_call(lua_State* L) {
+				C& c = source(L);
+				std::allocator<C> alloc{};
+				alloc.destroy(&c);
+				return 0;
+			}
+
+			static int index_call(lua_State* L) {
+				return detail::static_trampoline<(&real_index_call)>(L);
+			}
+
+			static int new_index_call(lua_State* L) {
+				return detail::static_trampoline<(&real_new_index_call)>(L);
+			}
+
+			static int length_call(lua_State* L) {
+				return detail::static_trampoline<(&real_length_call)>(L);
+			}
+
+			static int next_call(lua_State* L) {
+				return detail::static_trampoline<(&real_next_call)>(L);
+			}
+
+			static int walk_call(lua_State* L) {
+				return detail::static_trampoline<(&real_walk_call)>(L);
+			}
+
+			static int pairs_call(lua_State* L) {
+				return detail::static_trampoline<(&real_pairs_call)>(L);
+			}
+
+			static int add_call(lua_State* L) {
+				return detail::static_trampoline<(&real_add_call)>(L);
+			}
+
+			static int insert_call(lua_State* L) {
+				return detail::static_trampoline<(&real_insert_call)>(L);
+			}
+
+			static int erase_call(lua_State* L) {
+				return detail::static_trampoline<(&real_erase_call)>(L);
+			}
+
+			static int clear_call(lua_State* L) {
+				return detail::static_trampoline<(&real_clear_call)>(L);
+			}
+
+			static int destruct_call(lua_State* L) {
+				return detail::static_trampoline<(&real_destruct_call)>(L);
+			}
+
+			// Fills in the metatable on top of the stack
+			static void make_metatable(lua_State* L, bool owned) {
+				int t = lua_gettop(L);
+				const luaL_Reg methods[] = {
+					{ "add", &add_call },
+					{ "insert", &insert_call },
+					{ "erase", &erase_call },
+					{ "clear", &clear_call },
+					{ "size", &length_call },
+					{ "pairs", &pairs_call },
+					{ nullptr, nullptr }
+				};
+				lua_createtable(L, 0, 6);
+				luaL_setfuncs(L, methods, 0);
+				lua_pushcclosure(L, &index_call, 1);
+				lua_setfield(L, t, "__index");
+				const luaL_Reg metamethods[] = {
+					{ "__newindex", &new_index_call },
+					{ "__len", &length_call },
+					{ "__pairs", &pairs_call },
+					{ "__ipairs", &pairs_call },
+					{ nullptr, nullptr }
+				};
+				luaL_setfuncs(L, metamethods, 0);
+				if (owned) {
+					lua_pushcclosure(L, &destruct_call, 0);
+					lua_setfield(L, t, "__gc");
+				}
+			}
+		};
+	} // container_detail
+
+	namespace stack {
+		template <typename T>
+		struct pusher<as_container_t<T>> {
+			typedef meta::unqualified_t<T> C;
+			typedef container_detail::container_usertype_metatable<C> cumt_t;
+			typedef meta::all<std::is_lvalue_reference<T>, meta::neg<std::is_const<std::remove_reference_t<T>>>> is_view;
+
+			// A view: only the pointer is stored, laid out like a T*
+			template <typename Source>
+			static int push_source(lua_State* L, Source&& source, std::true_type) {
+				C** pref = static_cast<C**>(detail::usertype_newuserdata(L, sizeof(C*), detail::usertype_names<detail::container_view<C>>::metatable()));
+				*pref = std::addressof(source);
+				if (detail::new_usertype_metatable<detail::container_view<C>>(L)) {
+					cumt_t::make_metatable(L, false);
+				}
+				lua_setmetatable(L, -2);
+				return 1;
+			}
+
+			// Owned: laid out like any other usertype value
+			template <typename Source>
+			static int push_source(lua_State* L, Source&& source, std::false_type) {
+				C** pointerpointer = static_cast<C**>(detail::usertype_newuserdata(L, sizeof(C*) + sizeof(C), detail::usertype_names<detail::container_value<C>>::metatable()));
+				C* allocationtarget = reinterpret_cast<C*>(pointerpointer + 1);
+				*pointerpointer = allocationtarget;
+				std::allocator<C> alloc{};
+				alloc.construct(allocationtarget, std::forward<Source>(source));
+				if (detail::new_usertype_metatable<detail::container_value<C>>(L)) {
+					cumt_t::make_metatable(L, true);
+				}
+				lua_setmetatable(L, -2);
+				return 1;
+			}
+
+			static int push(lua_State* L, const as_container_t<T>& c) {
+				return push_source(L, c.source, is_view());
+			}
+
+			static int push(lua_State* L, as_container_t<T>&& c) {
+				return push_source(L, std::forward<T>(c.source), is_view());
+			}
+		};
+	} // stack
+} // sol
+
+#endif // SOL_CONTAINER_USERTYPE_HPP
@@ -0,0 +1,455 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2016 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_ERASED_USERTYPE_METATABLE_HPP
+#define SOL_ERASED_USERTYPE_METATABLE_HPP
+
+#include "usertype_metatable.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sol {
+
+	struct erased_tag {} const erased{};
+
+	namespace usertype_detail {
+		struct erased_member;
+
+		typedef int(*erased_invoke)(lua_State*, erased_member&);
+
+		// One registered name. The callable lives behind function, and the entry
+		// points are instantiated per (T, callable type) instead of per member,
+		// so every int (T::*)() const of a usertype shares the same code
+		struct erased_member {
+			std::string name;
+			std::shared_ptr<void> function;
+			erased_invoke index = nullptr;
+			// what member lookup tables point to for variables
+			variable_entry variable = { nullptr, nullptr, nullptr };
+			lua_CFunction index_closure = nullptr;
+			lua_CFunction new_index_closure = nullptr;
+			// plain lua_CFunctions are installed as they are
+			lua_CFunction raw = nullptr;
+			bool is_variable = false;
+#ifdef SOL_BINDING_STATS
+			detail::binding_record* record = nullptr;
+#endif // Binding Statistics
+
+			lua_CFunction closure(bool is_index) const {
+				return raw != nullptr ? raw : (is_index ? index_closure : new_index_closure);
+			}
+
+			int invoke(lua_State* L) {
+				return raw != nullptr ? raw(L) : index(L, *this);
+			}
+		};
+
+		template <typename T, typename F, bool is_index, bool is_variable>
+		int erased_invoke_with(lua_State* L, erased_member& m) {
+#ifdef SOL_BINDING_STATS
+			detail::binding_scope scope(m.record);
+#endif // Binding Statistics
+			return call_detail::call_wrapped<T, is_index, is_variable>(L, *static_cast<F*>(m.function.get()));
+		}
+
+		template <typename T, typename F, bool is_index>
+		int erased_variable_call(lua_State* L, void* m) {
+			return erased_invoke_with<T, F, is_index, true>(L, *static_cast<erased_member*>(m));
+		}
+
+		template <typename T, typename F, bool is_index, bool is_variable>
+		int erased_real_call(lua_State* L) {
+			erased_member& m = *static_cast<erased_member*>(lua_touserdata(L, upvalue_index(1)));
+			return erased_invoke_with<T, F, is_index, is_variable>(L, m);
+		}
+
+		template <typename T, typename F, bool is_index, bool is_variable>
+		int erased_call(lua_State* L) {
+			return detail::static_trampoline<(&erased_real_call<T, F, is_index, is_variable>)>(L);
+		}
+
+		template <typename T, typename F>
+		void make_erased_entry_points(erased_member& m, std::true_type) {
+			m.is_variable = true;
+			m.variable.index = &erased_variable_call<T, F, true>;
+			m.variable.new_index = &erased_variable_call<T, F, false>;
+		}
+
+		template <typename T, typename F>
+		void make_erased_entry_points(erased_member& m, std::false_type) {
+			m.index = &erased_invoke_with<T, F, true, false>;
+			m.index_closure = &erased_call<T, F, true, false>;
+			m.new_index_closure = &erased_call<T, F, false, false>;
+		}
+
+		inline void set_erased_raw(erased_member& m, lua_CFunction f) {
+			m.raw = f;
+		}
+
+		template <typename F>
+		inline void set_erased_raw(erased_member&, const F&) {}
+	} // usertype_detail
+
+	// Same features as usertype_metatable, but members are kept in a runtime
+	// list instead of a tuple, which trades a little dispatch speed for far
+	// fewer template instantiations per registered member
+	template <typename T>
+	struct erased_usertype_metatable : usertype_detail::registrar {
+		typedef usertype_detail::erased_member member;
+		std::vector<member> members;
+		member callconstruct;
+		member integerindex;
+		member integernewindex;
+		reference memberlookup;
+		int indexmember;
+		int newindexmember;
+		usertype_detail::base_flatten baseclassflatten;
+		usertype_detail::base_walk indexbaseclasspropogation;
+		usertype_detail::base_walk newindexbaseclasspropogation;
+		const detail::inheritance_table* baseclasstable;
+		bool hascallconstruct;
+		bool mustindex;
+		bool secondarymeta;
+		bool dynamicfields;
+
+		template <typename N, typename F, typename = std::enable_if_t<!meta::any_same<meta::unqualified_t<N>, base_classes_tag, call_construction, dynamic_fields_tag, integer_index_tag, integer_new_index_tag>::value>>
+		void add(N&& n, F&& f) {
+			typedef std::decay_t<F> Fx;
+			member m;
+			string_detail::string_shim name = usertype_detail::make_shim(std::forward<N>(n));
+			m.name.assign(name.data(), name.size());
+			usertype_detail::set_erased_raw(m, f);
+			m.function = std::make_shared<Fx>(std::forward<F>(f));
+			usertype_detail::make_erased_entry_points<T, Fx>(m, is_variable_binding<Fx>());
+			if (m.is_variable) {
+				mustindex = true;
+				secondarymeta = true;
+			}
+			else if (usertype_detail::is_indexer(name)) {
+				mustindex = true;
+			}
+			members.push_back(std::move(m));
+		}
+
+		template <typename F>
+		void add(call_construction, F&& f) {
+			typedef std::decay_t<F> Fx;
+			callconstruct.name = name_of(meta_function::call_function);
+			usertype_detail::set_erased_raw(callconstruct, f);
+			callconstruct.function = std::make_shared<Fx>(std::forward<F>(f));
+			usertype_detail::make_erased_entry_points<T, Fx>(callconstruct, std::false_type());
+			hascallconstruct = true;
+			secondarymeta = true;
+		}
+
+		template <typename N, typename F>
+		void add_integer_access(member& m, N&& n, F&& f) {
+			typedef std::decay_t<F> Fx;
+			string_detail::string_shim name = usertype_detail::make_shim(std::forward<N>(n));
+			m.name.assign(name.data(), name.size());
+			usertype_detail::set_erased_raw(m, f);
+			m.function = std::make_shared<Fx>(std::forward<F>(f));
+			usertype_detail::make_erased_entry_points<T, Fx>(m, std::false_type());
+			mustindex = true;
+		}
+
+		template <typename F>
+		void add(integer_index_tag n, F&& f) {
+			add_integer_access(integerindex, n, std::forward<F>(f));
+		}
+
+		template <typename F>
+		void add(integer_new_index_tag n, F&& f) {
+			add_integer_access(integernewindex, n, std::forward<F>(f));
+		}
+
+		void add(dynamic_fields_tag, bool enabled) {
+			if (!enabled) {
+				return;
+			}
+			dynamicfields = true;
+			mustindex = true;
+		}
+
+		template <typename... Bases>
+		void add(base_classes_tag, bases<Bases...>) {
+			if (sizeof...(Bases) < 1) {
+				return;
+			}
+			mustindex = true;
+			(void)detail::swallow{ 0, ((detail::has_derived<Bases>::value = true), 0)... };
+
+			baseclasstable = &detail::inheritance<T, Bases...>::table();
+			indexbaseclasspropogation = usertype_detail::walk_all_bases<true, Bases...>;
+			newindexbaseclasspropogation = usertype_detail::walk_all_bases<false, Bases...>;
+			baseclassflatten = usertype_detail::flatten_bases<Bases...>;
+		}
+
+		template <std::size_t... I, typename Tuple>
+		erased_usertype_metatable(usertype_detail::verified_tag, std::index_sequence<I...>, Tuple&& args) : indexmember(-1), newindexmember(-1),
+		baseclassflatten(usertype_detail::flatten_bases<>),
+		indexbaseclasspropogation(usertype_detail::walk_all_bases<true>), newindexbaseclasspropogation(usertype_detail::walk_all_bases<false>),
+		baseclasstable(nullptr), hascallconstruct(false), mustindex(false), secondarymeta(false), dynamicfields(false) {
+			members.reserve(sizeof...(I));
+			(void)detail::swallow{ 0,
+				(add(detail::forward_get<I * 2>(args), detail::forward_get<I * 2 + 1>(args)), 0)...
+			};
+			for (std::size_t i = 0; i < members.size(); ++i) {
+				if (members[i].name == name_of(meta_function::index)) {
+					indexmember = static_cast<int>(i);
+				}
+				else if (members[i].name == name_of(meta_function::new_index)) {
+					newindexmember = static_cast<int>(i);
+				}
+			}
+		}
+
+		template <typename... Args>
+		erased_usertype_metatable(usertype_detail::verified_tag v, Args&&... args) : erased_usertype_metatable(v, std::make_index_sequence<sizeof...(Args) / 2>(), std::forward_as_tuple(std::forward<Args>(args)...)) {}
+
+		template <typename... Args>
+		erased_usertype_metatable(usertype_detail::add_destructor_tag, Args&&... args) : erased_usertype_metatable(usertype_detail::verified, std::forward<Args>(args)..., "__gc", default_destructor) {}
+
+		template <typename... Args>
+		erased_usertype_metatable(usertype_detail::check_destructor_tag, Args&&... args) : erased_usertype_metatable(meta::condition<meta::all<std::is_destructible<T>, meta::neg<usertype_detail::has_destructor<Args...>>>, usertype_detail::add_destructor_tag, usertype_detail::verified_tag>(), std::forward<Args>(args)...) {}
+
+	public:
+		erased_usertype_metatable() : erased_usertype_metatable(meta::condition<std::is_default_constructible<T>, decltype(default_constructor), usertype_detail::check_destructor_tag>()) {}
+
+		template <typename Arg, typename... Args, meta::disable_any<
+			meta::any_same<meta::unqualified_t<Arg>,
+				usertype_detail::verified_tag,
+				usertype_detail::add_destructor_tag,
+				usertype_detail::check_destructor_tag,
+				erased_usertype_metatable
+			>,
+			meta::is_specialization_of<constructors, meta::unqualified_t<Arg>>,
+			meta::is_specialization_of<constructor_wrapper, meta::unqualified_t<Arg>>
+		> = meta::enabler>
+		erased_usertype_metatable(Arg&& arg, Args&&... args) : erased_usertype_metatable(meta::condition<meta::all<std::is_default_constructible<T>, meta::neg<usertype_detail::has_constructor<Arg, Args...>>>, decltype(default_constructor), usertype_detail::check_destructor_tag>(), std::forward<Arg>(arg), std::forward<Args>(args)...) {}
+
+		template <typename... Args, typename... CArgs>
+		erased_usertype_metatable(constructors<CArgs...> constructorlist, Args&&... args) : erased_usertype_metatable(usertype_detail::check_destructor_tag(), std::forward<Args>(args)..., "new", constructorlist) {}
+
+		template <typename... Args, typename... Fxs>
+		erased_usertype_metatable(constructor_wrapper<Fxs...> constructorlist, Args&&... args) : erased_usertype_metatable(usertype_detail::check_destructor_tag(), std::forward<Args>(args)..., "new", constructorlist) {}
+
+#ifdef SOL_BINDING_STATS
+		void register_bindings(lua_State* L) {
+			for (member& m : members) {
+				// destructors can run during lua_close, after the records are gone
+				if (m.name == name_of(meta_function::garbage_collect)) {
+					continue;
+				}
+				m.record = detail::register_binding(L, detail::usertype_names<T>::name() + "." + m.name);
+			}
+			if (hascallconstruct) {
+				callconstruct.record = detail::register_binding(L, detail::usertype_names<T>::name() + "." + callconstruct.name);
+			}
+			for (member* m : { &integerindex, &integernewindex }) {
+				if (m->function != nullptr) {
+					m->record = detail::register_binding(L, detail::usertype_names<T>::name() + "." + m->name);
+				}
+			}
+		}
+#endif // Binding Statistics
+
+		template <bool b>
+		int fallback(lua_State* L) {
+			int idx = b ? indexmember : newindexmember;
+			if (dynamicfields) {
+				int ret = usertype_detail::dynamic_field<b>(L, idx > -1);
+				if (ret > -1) {
+					return ret;
+				}
+			}
+			if (idx < 0) {
+				return usertype_detail::indexing_fail<b>(L);
+			}
+			return members[idx].invoke(L);
+		}
+
+		template <bool b, bool toplevel = false>
+		static int core_indexing_call(lua_State* L) {
+			erased_usertype_metatable& f = toplevel ? stack::get<light<erased_usertype_metatable>>(L, upvalue_index(1)) : stack::pop<light<erased_usertype_metatable>>(L);
+			static const int keyidx = -2 + static_cast<int>(b);
+			if (toplevel) {
+				member& integeraccess = b ? f.integerindex : f.integernewindex;
+				if (integeraccess.function != nullptr && usertype_detail::is_integer_key(L, keyidx)) {
+					return integeraccess.invoke(L);
+				}
+				if (stack::get<type>(L, keyidx) != type::string) {
+					return f.fallback<b>(L);
+				}
+			}
+			int ret = usertype_detail::call_member<b>(L, f.memberlookup, lua_absindex(L, keyidx));
+			if (ret > -1) {
+				return ret;
+			}
+			// Otherwise, the base may have been registered after us:
+			// we need to do propagating calls through the bases
+			string_detail::string_shim accessor = stack::get<string_detail::string_shim>(L, keyidx);
+			bool found = false;
+			usertype_detail::base_walk walkbaseclasses = b ? f.indexbaseclasspropogation : f.newindexbaseclasspropogation;
+			walkbaseclasses(L, found, ret, accessor);
+			if (found) {
+				return ret;
+			}
+			return toplevel ? f.fallback<b>(L) : -1;
+		}
+
+		static int real_index_call(lua_State* L) {
+			return core_indexing_call<true, true>(L);
+		}
+
+		static int real_new_index_call(lua_State* L) {
+			return core_indexing_call<false, true>(L);
+		}
+
+		static int index_call(lua_State* L) {
+			return detail::static_trampoline<(&real_index_call)>(L);
+		}
+
+		static int new_index_call(lua_State* L) {
+			return detail::static_trampoline<(&real_new_index_call)>(L);
+		}
+
+		void make_member_lookup(lua_State* L) {
+			lua_createtable(L, 0, static_cast<int>(members.size()));
+			int lookup = lua_gettop(L);
+			for (std::size_t i = 0; i < members.size(); ++i) {
+				member& m = members[i];
+				if (m.is_variable) {
+					m.variable.data = static_cast<void*>(&m);
+					lua_pushlightuserdata(L, static_cast<void*>(&m.variable));
+				}
+				else {
+					detail::count_hot_path(L, &hot_path_counters::index_closures);
+					stack::push(L, c_closure(m.closure(true), stack::push(L, light<member>(m))));
+				}
+				usertype_detail::add_member_lookup(L, lookup, string_detail::string_shim(m.name));
+			}
+			baseclassflatten(L, lookup);
+			memberlookup = reference(L, lookup);
+			lua_pop(L, 1);
+		}
+
+		virtual int push_um(lua_State* L) override {
+			return stack::push(L, std::move(*this));
+		}
+	};
+
+	namespace stack {
+		template <typename T>
+		struct pusher<erased_usertype_metatable<T>> {
+			typedef erased_usertype_metatable<T> umt_t;
+			typedef typename umt_t::member member;
+
+			static umt_t& make_cleanup(lua_State* L, umt_t&& umx) {
+				// Members are pointed to by light userdata from here on,
+				// so they have to be in their final place first
+				const char* gcmetakey = &detail::usertype_names<T>::gc_table()[0];
+				stack::push<user<umt_t>>(L, std::move(umx));
+				stack_reference umt(L, -1);
+				stack::set_field<true>(L, gcmetakey, umt);
+				umt.pop();
+
+				stack::get_field<true>(L, gcmetakey);
+				return stack::pop<light<umt_t>>(L);
+			}
+
+			static int push(lua_State* L, umt_t&& umx) {
+				detail::heap_origin_scope origin(L, "sol: usertype registration");
+
+				umt_t& um = make_cleanup(L, std::move(umx));
+#ifdef SOL_BINDING_STATS
+				um.register_bindings(L);
+#endif // Binding Statistics
+				um.make_member_lookup(L);
+				// The value metatable is also the usertype's table in Lua,
+				// so it is the one that holds every function
+				detail::count_hot_path(L, &hot_path_counters::new_metatables);
+				luaL_newmetatable(L, &detail::usertype_names<T>::metatable()[0]);
+				stack_reference t(L, -1);
+				bool hasdestructor = false;
+				for (member& m : um.members) {
+					if (m.is_variable || usertype_detail::is_indexer(string_detail::string_shim(m.name))) {
+						continue;
+					}
+					if (m.name == name_of(meta_function::garbage_collect)) {
+						hasdestructor = true;
+					}
+					stack::set_field(L, m.name, make_closure(m.closure(true), make_light(m)), t.stack_index());
+				}
+
+				if (um.baseclasstable != nullptr) {
+					lua_pushlightuserdata(L, const_cast<detail::inheritance_table*>(um.baseclasstable));
+				}
+				else {
+					lua_pushnil(L);
+				}
+				lua_rawsetp(L, t.stack_index(), detail::base_class_table_key());
+
+				stack::push(L, um.memberlookup);
+				lua_rawsetp(L, t.stack_index(), detail::base_class_member_lookup_key());
+				stack::push(L, make_closure(&umt_t::template core_indexing_call<true>, make_light(um)));
+				lua_rawsetp(L, t.stack_index(), detail::base_class_index_propogation_key());
+				stack::push(L, make_closure(&umt_t::template core_indexing_call<false>, make_light(um)));
+				lua_rawsetp(L, t.stack_index(), detail::base_class_new_index_propogation_key());
+
+				if (um.mustindex) {
+					stack::set_field(L, meta_function::index, make_closure(umt_t::index_call, make_light(um)), t.stack_index());
+					stack::set_field(L, meta_function::new_index, make_closure(umt_t::new_index_call, make_light(um)), t.stack_index());
+				}
+				else {
+					stack::set_field(L, meta_function::index, t, t.stack_index());
+				}
+				// metatable on the metatable
+				// for call constructor purposes and such
+				lua_createtable(L, 0, 1);
+				stack_reference metabehind(L, -1);
+				if (um.hascallconstruct) {
+					stack::set_field(L, meta_function::call_function, make_closure(um.callconstruct.closure(true), make_light(um.callconstruct)), metabehind.stack_index());
+				}
+				if (um.secondarymeta) {
+					stack::set_field(L, meta_function::index, make_closure(umt_t::index_call, make_light(um)), metabehind.stack_index());
+					stack::set_field(L, meta_function::new_index, make_closure(umt_t::new_index_call, make_light(um)), metabehind.stack_index());
+				}
+				stack::set_field(L, metatable_key, metabehind, t.stack_index());
+				metabehind.pop();
+
+				// Pointer types, AKA "references" from C++, and unique usertypes
+				// index through the value metatable instead of repeating its functions
+				usertype_detail::new_shared_metatable<T*>(L, t.stack_index());
+				lua_pop(L, 1);
+				int unique = usertype_detail::new_shared_metatable<detail::unique_usertype<T>>(L, t.stack_index());
+				if (hasdestructor) {
+					stack::set_field<false, true>(L, meta_function::garbage_collect, detail::unique_destruct<T>, unique);
+				}
+				lua_pop(L, 1);
+				return 1;
+			}
+		};
+	} // stack
+} // sol
+
+#endif // SOL_ERASED_USERTYPE_METATABLE_HPP
@@ -26,6 +26,7 @@
 #include "stack.hpp"
 #include "function_result.hpp"
 #include "function_types.hpp"
+#include "call_latency.hpp"
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -34,6 +35,10 @@ namespace sol {
 	template <typename base_t>
 	class basic_function : public base_t {
 	private:
+#ifdef SOL_CALL_LATENCY
+		mutable detail::latency_record* latency = nullptr;
+#endif // Call Latency
+
 		void luacall(std::ptrdiff_t argcount, std::ptrdiff_t resultcount) const {
 			lua_callk(base_t::lua_state(), static_cast<int>(argcount), static_cast<int>(resultcount), 0, nullptr);
 		}
@@ -88,8 +93,20 @@ namespace sol {
 			return call<Ret...>(std::forward<Args>(args)...);
 		}
 
+		// Records this function's calls under name instead of where it was defined
+		void set_latency_name(const std::string& name) {
+#ifdef SOL_CALL_LATENCY
+			latency = detail::register_latency(base_t::lua_state(), name);
+#else
+			(void)name;
+#endif // Call Latency
+		}
+
 		template<typename... Ret, typename... Args>
 		decltype(auto) call(Args&&... args) const {
+#ifdef SOL_CALL_LATENCY
+			detail::latency_scope latencyscope(*this, latency);
+#endif // Call Latency
 			base_t::push();
 			int pushcount = stack::multi_push_reference(base_t::lua_state(), std::forward<Args>(args)...);
 			return invoke(types<Ret...>(), std::make_index_sequence<sizeof...(Ret)>(), pushcount);
@@ -0,0 +1,446 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2016 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_HEAP_PROFILER_HPP
+#define SOL_HEAP_PROFILER_HPP
+
+#include "compatibility.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <iomanip>
+
+namespace sol {
+	struct heap_site {
+		// source:line of the innermost Lua function that was running,
+		// or "[C++]" when the allocation happened outside of any Lua call
+		std::string location;
+		// the C function running on top of that Lua code (usually a sol binding), if any
+		std::string function;
+		// "script" for allocations Lua made on its own behalf, or which
+		// part of sol made the allocation (see heap_origins in the docs)
+		std::string origin;
+		// estimates: each sampled block stands in for the bytes sampled over
+		std::size_t live_bytes = 0;
+		std::size_t live_blocks = 0;
+		std::size_t allocated_bytes = 0;
+	};
+
+	// A lua_Alloc that samples allocations and remembers where in the
+	// script (and in which binding) each sampled block was allocated
+	// Hand it to a state with sol::state(profiler), which also attaches it;
+	// it must outlive the state and must not be shared between states
+	// It borrows the state's debug hook only while a sample waits for its
+	// location, and never replaces a hook something else installed
+	class heap_profiler {
+	private:
+		struct site_record {
+			heap_site site;
+			// A pending record holds the blocks sampled while Lua code was running,
+			// until the next debug hook event says where that code was; it then
+			// forwards to the record of that site, and is deleted once it no
+			// longer has any blocks pointing at it
+			site_record* forward = nullptr;
+			std::size_t references = 0;
+			bool pending = false;
+		};
+
+		union header {
+			struct {
+				site_record* site;
+				std::size_t weight;
+			} sample;
+			std::max_align_t alignment;
+		};
+
+		lua_State* L;
+		std::unordered_map<std::string, site_record> sites;
+		std::vector<site_record*> unresolved;
+		const char* current_origin;
+		std::size_t interval;
+		std::size_t countdown;
+		std::size_t live;
+
+		site_record* find_site(std::string location, std::string function, std::string origin) {
+			std::string key = location;
+			key += '\n';
+			key += function;
+			key += '\n';
+			key += origin;
+			auto it = sites.find(key);
+			if (it == sites.end()) {
+				site_record record;
+				record.site.location = std::move(location);
+				record.site.function = std::move(function);
+				record.site.origin = std::move(origin);
+				it = sites.emplace(std::move(key), std::move(record)).first;
+			}
+			return &it->second;
+		}
+
+		// Runs inside lua_Alloc, where Lua may be halfway through moving its
+		// stack: lua_getstack only walks the CallInfo list to see whether any
+		// Lua call is active, and reading where that call is waits for the hook,
+		// which is armed here (lua_sethook is safe to call at any point)
+		site_record* capture() {
+			std::string origin = current_origin != nullptr ? current_origin : "script";
+			lua_Debug ar;
+			if (L == nullptr || lua_getstack(L, 0, &ar) == 0) {
+				return find_site("[C++]", std::string(), std::move(origin));
+			}
+			lua_Hook current = lua_gethook(L);
+			if (current != &hook) {
+				if (current != nullptr) {
+					// someone else's hook (sol::profiler, a debugger): leave it alone
+					return find_site("?", std::string(), std::move(origin));
+				}
+				lua_sethook(L, &hook, LUA_MASKCALL | LUA_MASKRET | LUA_MASKCOUNT, 1);
+			}
+			for (site_record* record : unresolved) {
+				if (record->site.origin == origin) {
+					return record;
+				}
+			}
+			std::unique_ptr<site_record> record(new site_record());
+			record->site.origin = std::move(origin);
+			record->pending = true;
+			unresolved.push_back(record.get());
+			return record.release();
+		}
+
+		void release(site_record* record) {
+			if (record->pending && --record->references == 0 && record->forward != nullptr) {
+				delete record;
+			}
+		}
+
+		// Charges every block sampled since the last hook event to location and function
+		void resolve(const std::string& location, const std::string& function) {
+			while (!unresolved.empty()) {
+				site_record* record = unresolved.back();
+				site_record* target = find_site(location, function, record->site.origin);
+				target->site.live_bytes += record->site.live_bytes;
+				target->site.live_blocks += record->site.live_blocks;
+				target->site.allocated_bytes += record->site.allocated_bytes;
+				record->forward = target;
+				unresolved.pop_back();
+				if (record->references == 0) {
+					delete record;
+				}
+			}
+		}
+
+		static std::string line_of(const lua_Debug& ar, int line) {
+			std::string location = ar.short_src;
+			location += ":";
+			location += std::to_string(line);
+			return location;
+		}
+
+		// The first Lua frame at or above level, the way the allocation would have seen it
+		// If function is empty, it takes the name of a C function passed on the way there:
+		// a binding wrapped in another C function (binding stats) has no name of its own
+		static std::string locate(lua_State* T, int level, std::string* function = nullptr) {
+			lua_Debug ar;
+			for (; lua_getstack(T, level, &ar) != 0; ++level) {
+				bool named = function != nullptr && function->empty();
+				lua_getinfo(T, named ? "Sln" : "Sl", &ar);
+				if (ar.currentline >= 0) {
+					return line_of(ar, ar.currentline);
+				}
+				if (named && ar.name != nullptr) {
+					*function = ar.name;
+				}
+			}
+			return "[C++]";
+		}
+
+		// The hook is disarmed by its first event, which places everything
+		// sampled since it was armed: nothing runs while no sample is waiting
+		void on_hook(lua_State* T, lua_Debug* ar) {
+			lua_sethook(T, nullptr, 0, 0);
+			if (unresolved.empty()) {
+				return;
+			}
+			// never let an exception escape into Lua: the samples stay pending instead
+			try {
+				switch (ar->event) {
+				case LUA_HOOKCOUNT:
+					// the instruction after the one that allocated, normally on the same line
+					lua_getinfo(T, "Sl", ar);
+					resolve(line_of(*ar, ar->currentline), std::string());
+					break;
+				case LUA_HOOKRET:
+					lua_getinfo(T, "Sln", ar);
+					if (ar->currentline < 0) {
+						// a C function is returning: the blocks are its own, made on the caller's line
+						std::string function = ar->name != nullptr ? ar->name : "";
+						std::string location = locate(T, 1, &function);
+						resolve(location, function);
+					}
+					else {
+						resolve(line_of(*ar, ar->currentline), std::string());
+					}
+					break;
+				default:
+					// calls: the caller was still running its line
+					resolve(locate(T, 1), std::string());
+					break;
+				}
+			}
+			catch (...) {}
+		}
+
+		static void hook(lua_State* T, lua_Debug* ar) {
+			heap_profiler* self = from(T);
+			if (self != nullptr) {
+				self->on_hook(T, ar);
+			}
+		}
+
+		// How many bytes a new block of size bytes stands for, or 0 if it is not sampled
+		std::size_t sample_weight(std::size_t size) {
+			if (interval == 0) {
+				return size;
+			}
+			if (size >= countdown) {
+				countdown = interval;
+				return (std::max)(size, interval);
+			}
+			countdown -= size;
+			return 0;
+		}
+
+		void track(header* h, std::size_t size) {
+			std::size_t weight = sample_weight(size);
+			h->sample.site = nullptr;
+			h->sample.weight = weight;
+			if (weight != 0) {
+				// never let an exception escape into Lua's allocator: the sample is dropped instead
+				try {
+					h->sample.site = capture();
+				}
+				catch (...) {}
+			}
+			if (h->sample.site != nullptr) {
+				heap_site& site = h->sample.site->site;
+				site.live_bytes += weight;
+				site.allocated_bytes += weight;
+				++site.live_blocks;
+				++h->sample.site->references;
+			}
+		}
+
+		void untrack(header* h) {
+			site_record* record = h->sample.site;
+			if (record == nullptr) {
+				return;
+			}
+			heap_site& site = record->forward != nullptr ? record->forward->site : record->site;
+			site.live_bytes -= h->sample.weight;
+			--site.live_blocks;
+			h->sample.site = nullptr;
+			release(record);
+		}
+
+	public:
+		// interval is the average number of bytes between samples: 0 records every allocation
+		heap_profiler(std::size_t sample_interval = 64 * 1024) : L(nullptr), current_origin(nullptr), interval(sample_interval), countdown(sample_interval), live(0) {}
+
+		heap_profiler(const heap_profiler&) = delete;
+		heap_profiler& operator=(const heap_profiler&) = delete;
+
+		~heap_profiler() {
+			for (site_record* record : unresolved) {
+				delete record;
+			}
+		}
+
+		static void* allocate(void* ud, void* ptr, std::size_t osize, std::size_t nsize) {
+			heap_profiler& self = *static_cast<heap_profiler*>(ud);
+			header* h = ptr == nullptr ? nullptr : static_cast<header*>(ptr) - 1;
+			if (nsize == 0) {
+				if (h != nullptr) {
+					self.untrack(h);
+					self.live -= osize;
+					std::free(h);
+				}
+				return nullptr;
+			}
+			// a reallocated block is charged to whoever grew it
+			std::size_t oldsize = h == nullptr ? 0 : osize;
+			header* nh = static_cast<header*>(std::realloc(h, sizeof(header) + nsize));
+			if (nh == nullptr) {
+				return nullptr;
+			}
+			if (h != nullptr) {
+				self.untrack(nh);
+			}
+			self.live = self.live - oldsize + nsize;
+			self.track(nh, nsize);
+			return static_cast<void*>(nh + 1);
+		}
+
+		// Returns the profiler a state was created with, or nullptr if it was created with some other allocator
+		static heap_profiler* from(lua_State* L) {
+			void* ud = nullptr;
+			lua_Alloc f = lua_getallocf(L, &ud);
+			return f == &allocate ? static_cast<heap_profiler*>(ud) : nullptr;
+		}
+
+		// Lets the profiler arm the debug hook that tells it where Lua code is;
+		// sol::state(profiler) does this for you
+		void attach(lua_State* state) {
+			L = state;
+		}
+
+		// Removes the hook if it is armed; call it while the state is still open
+		void detach() {
+			if (L != nullptr && lua_gethook(L) == &hook) {
+				lua_sethook(L, nullptr, 0, 0);
+			}
+			resolve("?", std::string());
+			L = nullptr;
+		}
+
+		// Marks the allocations made until the returned value is passed back to
+		// end_origin as made by origin (a string literal) instead of by the script
+		// The outermost origin wins, so the table a container pusher creates
+		// while a usertype is being registered is charged to the registration
+		const char* begin_origin(const char* origin) {
+			const char* previous = current_origin;
+			if (current_origin == nullptr) {
+				current_origin = origin;
+			}
+			return previous;
+		}
+
+		void end_origin(const char* previous) {
+			current_origin = previous;
+		}
+
+		// Bytes Lua has live right now, sampled or not
+		std::size_t live_bytes() const {
+			return live;
+		}
+
+		std::size_t sample_interval() const {
+			return interval;
+		}
+
+		// Every site that still holds memory, biggest first
+		std::vector<heap_site> live_sites() const {
+			std::vector<heap_site> r;
+			for (const auto& kvp : sites) {
+				if (kvp.second.site.live_bytes != 0) {
+					r.push_back(kvp.second.site);
+				}
+			}
+			std::sort(r.begin(), r.end(), [](const heap_site& a, const heap_site& b) {
+				return a.live_bytes > b.live_bytes;
+			});
+			return r;
+		}
+
+		// Every site that was ever sampled, including ones that freed everything, biggest allocators first
+		std::vector<heap_site> all_sites() const {
+			std::vector<heap_site> r;
+			r.reserve(sites.size());
+			for (const auto& kvp : sites) {
+				r.push_back(kvp.second.site);
+			}
+			std::sort(r.begin(), r.end(), [](const heap_site& a, const heap_site& b) {
+				return a.allocated_bytes > b.allocated_bytes;
+			});
+			return r;
+		}
+
+		void write_report(std::ostream& out) const {
+			out << "live bytes: " << live << " (sampled every " << interval << " bytes)\n";
+			out << std::right << std::setw(12) << "live" << std::setw(10) << "blocks" << std::setw(14) << "allocated"
+				<< "  " << std::left << std::setw(28) << "origin" << std::setw(32) << "location" << "function" << '\n';
+			for (const heap_site& site : live_sites()) {
+				out << std::right << std::setw(12) << site.live_bytes << std::setw(10) << site.live_blocks << std::setw(14) << site.allocated_bytes
+					<< "  " << std::left << std::setw(28) << site.origin << std::setw(32) << site.location << site.function << '\n';
+			}
+		}
+
+		std::string report() const {
+			std::ostringstream out;
+			write_report(out);
+			return out.str();
+		}
+
+		// Forgets the allocated_bytes history, but keeps live blocks attributed
+		void reset_allocated() {
+			for (auto& kvp : sites) {
+				kvp.second.site.allocated_bytes = kvp.second.site.live_bytes;
+			}
+			for (site_record* record : unresolved) {
+				record->site.allocated_bytes = record->site.live_bytes;
+			}
+		}
+	};
+
+	namespace detail {
+#ifdef SOL_HEAP_ORIGINS
+		// Attributes allocations made while it is alive to one part of sol,
+		// when the state is being profiled; otherwise it only checks the allocator
+		class heap_origin_scope {
+		private:
+			heap_profiler* profiler;
+			const char* previous;
+
+		public:
+			heap_origin_scope(lua_State* L, const char* origin) noexcept : profiler(L == nullptr ? nullptr : heap_profiler::from(L)), previous(nullptr) {
+				if (profiler != nullptr) {
+					previous = profiler->begin_origin(origin);
+				}
+			}
+
+			heap_origin_scope(const heap_origin_scope&) = delete;
+			heap_origin_scope& operator=(const heap_origin_scope&) = delete;
+
+			~heap_origin_scope() {
+				if (profiler != nullptr) {
+					profiler->end_origin(previous);
+				}
+			}
+		};
+#else
+		class heap_origin_scope {
+		public:
+			heap_origin_scope(lua_State*, const char*) noexcept {}
+
+			heap_origin_scope(const heap_origin_scope&) = delete;
+			heap_origin_scope& operator=(const heap_origin_scope&) = delete;
+		};
+#endif // Heap Origins
+	} // detail
+} // sol
+
+#endif // SOL_HEAP_PROFILER_HPP
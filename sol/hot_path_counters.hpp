@@ -0,0 +1,124 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2016 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_HOT_PATH_COUNTERS_HPP
+#define SOL_HOT_PATH_COUNTERS_HPP
+
+#include "compatibility.hpp"
+#include <cstddef>
+#include <algorithm>
+#ifdef SOL_HOT_PATH_COUNTERS
+#include <new>
+#endif // Hot Path Counters
+
+namespace sol {
+	struct hot_path_counters {
+		std::size_t refs = 0;
+		std::size_t unrefs = 0;
+		std::size_t new_metatables = 0;
+		std::size_t get_metatables = 0;
+		std::size_t new_userdata = 0;
+		std::size_t index_closures = 0;
+		// highest lua_gettop seen at any of the counted points
+		std::size_t peak_stack = 0;
+	};
+
+	// The difference between two snapshots: how much happened in between
+	// peak_stack is not a count, so the later snapshot's value is kept
+	inline hot_path_counters operator-(const hot_path_counters& later, const hot_path_counters& earlier) {
+		hot_path_counters d;
+		d.refs = later.refs - earlier.refs;
+		d.unrefs = later.unrefs - earlier.unrefs;
+		d.new_metatables = later.new_metatables - earlier.new_metatables;
+		d.get_metatables = later.get_metatables - earlier.get_metatables;
+		d.new_userdata = later.new_userdata - earlier.new_userdata;
+		d.index_closures = later.index_closures - earlier.index_closures;
+		d.peak_stack = later.peak_stack;
+		return d;
+	}
+
+	namespace detail {
+#ifdef SOL_HOT_PATH_COUNTERS
+		inline const void* hot_path_counters_key() {
+			static const char key = 0;
+			return &key;
+		}
+
+		inline hot_path_counters* find_hot_path_counters(lua_State* L) {
+			lua_rawgetp(L, LUA_REGISTRYINDEX, hot_path_counters_key());
+			hot_path_counters* counters = static_cast<hot_path_counters*>(lua_touserdata(L, -1));
+			lua_pop(L, 1);
+			return counters;
+		}
+
+		inline hot_path_counters& ensure_hot_path_counters(lua_State* L) {
+			hot_path_counters* counters = find_hot_path_counters(L);
+			if (counters != nullptr) {
+				return *counters;
+			}
+			// plain data: no __gc needed, Lua frees it with the state
+			counters = new (lua_newuserdata(L, sizeof(hot_path_counters))) hot_path_counters();
+			lua_rawsetp(L, LUA_REGISTRYINDEX, hot_path_counters_key());
+			return *counters;
+		}
+#endif // Hot Path Counters
+
+		inline void count_hot_path(lua_State* L, std::size_t hot_path_counters::* counter) {
+#ifdef SOL_HOT_PATH_COUNTERS
+			if (L == nullptr) {
+				return;
+			}
+			int top = lua_gettop(L);
+			hot_path_counters& counters = ensure_hot_path_counters(L);
+			++(counters.*counter);
+			counters.peak_stack = (std::max)(counters.peak_stack, static_cast<std::size_t>(top));
+#else
+			(void)L;
+			(void)counter;
+#endif // Hot Path Counters
+		}
+	} // detail
+
+	inline hot_path_counters hot_path_snapshot(lua_State* L) {
+#ifdef SOL_HOT_PATH_COUNTERS
+		hot_path_counters* counters = detail::find_hot_path_counters(L);
+		if (counters != nullptr) {
+			return *counters;
+		}
+#else
+		(void)L;
+#endif // Hot Path Counters
+		return hot_path_counters();
+	}
+
+	inline void reset_hot_path_counters(lua_State* L) {
+#ifdef SOL_HOT_PATH_COUNTERS
+		hot_path_counters* counters = detail::find_hot_path_counters(L);
+		if (counters != nullptr) {
+			*counters = hot_path_counters();
+		}
+#else
+		(void)L;
+#endif // Hot Path Counters
+	}
+} // sol
+
+#endif // SOL_HOT_PATH_COUNTERS_HPP
@@ -24,6 +24,7 @@
 
 #include "types.hpp"
 #include <atomic>
+#include <vector>
 
 namespace sol {
 	template <typename... Args>
@@ -57,60 +58,72 @@ namespace sol {
 		template <typename T>
 		const std::size_t id_for<T>::value = unique_id();
 
-		inline decltype(auto) base_class_check_key() {
-			static const auto& key = u8"♡o｡.(✿ฺ｡ ✿ฺ)";
-			return key;
+		// Sol's own metatable slots are keyed by the address of a static:
+		// rawgetp never hashes a string, and no user key can collide with them
+		inline const void* base_class_index_propogation_key() {
+			static const char key = 0;
+			return &key;
 		}
 
-		inline decltype(auto) base_class_cast_key() {
-			static const auto& key = u8"(◕‿◕✿)";
-			return key;
+		inline const void* base_class_new_index_propogation_key() {
+			static const char key = 0;
+			return &key;
 		}
 
-		inline decltype(auto) base_class_index_propogation_key() {
-			static const auto& key = u8"\xF0\x9F\x8C\xB2.index";
-			return key;
+		inline const void* base_class_member_lookup_key() {
+			static const char key = 0;
+			return &key;
 		}
 
-		inline decltype(auto) base_class_new_index_propogation_key() {
-			static const auto& key = u8"\xF0\x9F\x8C\xB2.new_index";
-			return key;
+		inline const void* base_class_table_key() {
+			static const char key = 0;
+			return &key;
 		}
 
-		template <typename T, typename... Bases>
-		struct inheritance {
-			static bool type_check_bases(types<>, std::size_t) {
-				return false;
+		typedef void* (*base_cast_function)(void*);
+
+		// Every type a registered usertype can be converted to, itself included,
+		// indexed by id_for<U>::value: checks and casts are a single lookup
+		struct inheritance_table {
+			std::vector<base_cast_function> casts;
+
+			void add(std::size_t ti, base_cast_function f) {
+				if (casts.size() <= ti) {
+					casts.resize(ti + 1, nullptr);
+				}
+				casts[ti] = f;
 			}
 
-			template <typename Base, typename... Args>
-			static bool type_check_bases(types<Base, Args...>, std::size_t ti) {
-				return ti != id_for<Base>::value || type_check_bases(types<Args...>(), ti);
+			bool check(std::size_t ti) const {
+				return ti < casts.size() && casts[ti] != nullptr;
 			}
 
-			static bool type_check(std::size_t ti) {
-				return ti != id_for<T>::value || type_check_bases(types<Bases...>(), ti);
+			void* cast(void* data, std::size_t ti) const {
+				return check(ti) ? casts[ti](data) : nullptr;
 			}
+		};
 
-			static void* type_cast_bases(types<>, T*, std::size_t) {
-				return nullptr;
+		template <typename T, typename... Bases>
+		struct inheritance {
+			template <typename Base>
+			static void* cast_to(void* data) {
+				// Make sure to convert to T first, so multiple inheritance adjusts the pointer properly
+				return static_cast<void*>(static_cast<Base*>(static_cast<T*>(data)));
 			}
 
-			template <typename Base, typename... Args>
-			static void* type_cast_bases(types<Base, Args...>, T* data, std::size_t ti) {
-				// Make sure to convert to T first, and then dynamic cast to the proper type
-				return ti != id_for<Base>::value ? type_cast_bases(types<Args...>(), data, ti) : static_cast<void*>(static_cast<Base*>(data));
+			static inheritance_table make_table() {
+				inheritance_table t;
+				t.add(id_for<T>::value, &cast_to<T>);
+				(void)swallow{ 0, (t.add(id_for<Bases>::value, &cast_to<Bases>), 0)... };
+				return t;
 			}
 
-			static void* type_cast(void* voiddata, std::size_t ti) {
-				T* data = static_cast<T*>(voiddata);
-				return static_cast<void*>(ti != id_for<T>::value ? type_cast_bases(types<Bases...>(), data, ti) : data);
+			static const inheritance_table& table() {
+				static const inheritance_table t = make_table();
+				return t;
 			}
 		};
 
-		using inheritance_check_function = decltype(&inheritance<void>::type_check);
-		using inheritance_cast_function = decltype(&inheritance<void>::type_cast);
-
 	} // detail
 } // sol
 
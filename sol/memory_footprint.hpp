@@ -0,0 +1,294 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2016 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_MEMORY_FOOTPRINT_HPP
+#define SOL_MEMORY_FOOTPRINT_HPP
+
+#include "state.hpp"
+#include "accounting_allocator.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <iomanip>
+
+namespace sol {
+	struct object_footprint {
+		// bytes sol asks Lua for, following the layouts in usertype_memory
+		std::size_t requested = 0;
+		// bytes each object keeps live in the state, Lua's own headers included
+		std::size_t measured = 0;
+	};
+
+	// What registering a usertype leaves live in the state, after a full collection
+	struct registration_footprint {
+		std::size_t total = 0;
+		std::size_t tables = 0;
+		std::size_t functions = 0;
+		std::size_t userdata = 0;
+		std::size_t strings = 0;
+		std::size_t other = 0;
+	};
+
+	// What each object registering a usertype creates takes on its own: a table's
+	// header and slots, without the functions and strings stored in them,
+	// and for the gc_table the userdata holding the usertype_metatable
+	struct registration_tables {
+		std::size_t value_metatable = 0;
+		std::size_t pointer_metatable = 0;
+		std::size_t unique_metatable = 0;
+		std::size_t metabehind = 0;
+		std::size_t gc_table = 0;
+	};
+
+	struct usertype_footprint {
+		std::string name;
+		object_footprint value;
+		object_footprint pointer;
+		object_footprint unique;
+		registration_footprint registration;
+		registration_tables per_table;
+	};
+
+	struct closure_footprint {
+		std::string name;
+		object_footprint closure;
+	};
+
+	namespace detail {
+		inline std::size_t footprint_delta(std::size_t after, std::size_t before) {
+			return after > before ? after - before : 0;
+		}
+
+		// Pushes count objects with push(L) and returns the bytes each one costs
+		// One object is pushed and collected first, so that metatables
+		// and strings the first push creates are not charged to every object
+		template <typename Push>
+		std::size_t measure_pushes(lua_State* L, accounting_allocator& allocator, std::size_t count, Push&& push) {
+			int top = lua_gettop(L);
+			luaL_checkstack(L, static_cast<int>(count) + LUA_MINSTACK, "not enough stack space to measure a footprint");
+			push(L);
+			lua_settop(L, top);
+			lua_gc(L, LUA_GCCOLLECT, 0);
+			lua_gc(L, LUA_GCSTOP, 0);
+			std::size_t before = allocator.live_bytes();
+			for (std::size_t i = 0; i < count; ++i) {
+				push(L);
+			}
+			std::size_t after = allocator.live_bytes();
+			lua_settop(L, top);
+			lua_gc(L, LUA_GCRESTART, 0);
+			lua_gc(L, LUA_GCCOLLECT, 0);
+			return footprint_delta(after, before) / (count == 0 ? 1 : count);
+		}
+
+		// Bytes a fresh table with as many array and hash entries as the table at index takes
+		inline std::size_t measure_table(lua_State* L, accounting_allocator& allocator, int index) {
+			index = lua_absindex(L, index);
+			int entries = 0;
+			lua_pushnil(L);
+			while (lua_next(L, index) != 0) {
+				lua_pop(L, 1);
+				++entries;
+			}
+			int narr = static_cast<int>(lua_rawlen(L, index));
+			lua_gc(L, LUA_GCSTOP, 0);
+			std::size_t before = allocator.live_bytes();
+			lua_createtable(L, narr, entries - narr);
+			std::size_t after = allocator.live_bytes();
+			lua_pop(L, 1);
+			lua_gc(L, LUA_GCRESTART, 0);
+			return footprint_delta(after, before);
+		}
+
+		inline std::size_t measure_metatable(lua_State* L, accounting_allocator& allocator, const std::string& key) {
+			luaL_getmetatable(L, key.c_str());
+			std::size_t r = lua_istable(L, -1) ? measure_table(L, allocator, -1) : 0;
+			lua_pop(L, 1);
+			return r;
+		}
+
+		template <typename T>
+		registration_tables measure_registration_tables(lua_State* L, accounting_allocator& allocator) {
+			registration_tables r;
+			r.value_metatable = measure_metatable(L, allocator, detail::usertype_names<T>::metatable());
+			r.pointer_metatable = measure_metatable(L, allocator, detail::usertype_names<T*>::metatable());
+			r.unique_metatable = measure_metatable(L, allocator, detail::usertype_names<detail::unique_usertype<T>>::metatable());
+			// the pointer and unique metatables share the value metatable's metatable
+			luaL_getmetatable(L, detail::usertype_names<T>::metatable().c_str());
+			if (lua_istable(L, -1) && lua_getmetatable(L, -1) != 0) {
+				r.metabehind = measure_table(L, allocator, -1);
+				lua_pop(L, 1);
+			}
+			lua_pop(L, 1);
+			lua_getglobal(L, detail::usertype_names<T>::gc_table().c_str());
+			if (type_of(L, -1) == type::userdata) {
+				std::size_t size = lua_rawlen(L, -1);
+				lua_gc(L, LUA_GCSTOP, 0);
+				std::size_t before = allocator.live_bytes();
+				lua_newuserdata(L, size);
+				r.gc_table = footprint_delta(allocator.live_bytes(), before);
+				lua_pop(L, 1);
+				lua_gc(L, LUA_GCRESTART, 0);
+			}
+			lua_pop(L, 1);
+			return r;
+		}
+
+		inline registration_footprint footprint_difference(const memory_stats& after, const memory_stats& before) {
+			registration_footprint r;
+			r.total = footprint_delta(after.total.live_bytes, before.total.live_bytes);
+			r.tables = footprint_delta(after.tables.live_bytes, before.tables.live_bytes);
+			r.functions = footprint_delta(after.functions.live_bytes, before.functions.live_bytes);
+			r.userdata = footprint_delta(after.userdata.live_bytes, before.userdata.live_bytes);
+			r.strings = footprint_delta(after.strings.live_bytes, before.strings.live_bytes);
+			r.other = footprint_delta(after.other.live_bytes, before.other.live_bytes);
+			return r;
+		}
+	} // detail
+
+	// Measures T in a fresh state: registration(lua) must register T as a usertype,
+	// and sample is copied to create the value and unique objects
+	template <typename T, typename Registration>
+	usertype_footprint measure_usertype_footprint(Registration&& registration, const T& sample, std::size_t count = 256) {
+		typedef std::unique_ptr<T> unique_t;
+		usertype_footprint footprint;
+		footprint.name = detail::usertype_names<T>::name();
+		footprint.value.requested = sizeof(T*) + sizeof(T);
+		footprint.pointer.requested = sizeof(T*);
+		footprint.unique.requested = sizeof(T*) + sizeof(detail::special_destruct_func) + sizeof(unique_t);
+
+		accounting_allocator allocator;
+		state lua(allocator);
+		lua_gc(lua, LUA_GCCOLLECT, 0);
+		memory_stats before = allocator.stats();
+		registration(lua);
+		lua_gc(lua, LUA_GCCOLLECT, 0);
+		footprint.registration = detail::footprint_difference(allocator.stats(), before);
+		footprint.per_table = detail::measure_registration_tables<T>(lua, allocator);
+
+		T referred = sample;
+		footprint.value.measured = detail::measure_pushes(lua, allocator, count, [&sample](lua_State* L) { stack::push(L, sample); });
+		footprint.pointer.measured = detail::measure_pushes(lua, allocator, count, [&referred](lua_State* L) { stack::push(L, &referred); });
+		footprint.unique.measured = detail::measure_pushes(lua, allocator, count, [&sample](lua_State* L) { stack::push(L, unique_t(new T(sample))); });
+		return footprint;
+	}
+
+	template <typename T>
+	usertype_footprint measure_usertype_footprint(const T& sample, std::size_t count = 256) {
+		return measure_usertype_footprint<T>([](state& lua) { lua.new_usertype<T>(detail::usertype_names<T>::name()); }, sample, count);
+	}
+
+	// Measures one function pushed the way set_function would push it:
+	// stateful callables become a user<F> with its own gc metatable plus a closure,
+	// requested is the size of that user<F>
+	template <typename Fx>
+	closure_footprint measure_closure_footprint(std::string name, const Fx& fx, std::size_t count = 256) {
+		typedef function_detail::functor_function<Fx> functor_t;
+		closure_footprint footprint;
+		footprint.name = std::move(name);
+		footprint.closure.requested = sizeof(functor_t);
+
+		accounting_allocator allocator;
+		state lua(allocator);
+		footprint.closure.measured = detail::measure_pushes(lua, allocator, count, [&fx](lua_State* L) { stack::push<function_sig<>>(L, fx); });
+		return footprint;
+	}
+
+	// Collects footprints and prints them as one table per kind
+	class footprint_report {
+	private:
+		std::vector<usertype_footprint> types;
+		std::vector<closure_footprint> closures;
+
+		static std::string cell(const object_footprint& f) {
+			std::ostringstream out;
+			out << f.measured << " (" << f.requested << ")";
+			return out.str();
+		}
+
+	public:
+		template <typename T, typename... Args>
+		footprint_report& add_usertype(Args&&... args) {
+			types.push_back(measure_usertype_footprint<T>(std::forward<Args>(args)...));
+			return *this;
+		}
+
+		template <typename Fx>
+		footprint_report& add_closure(std::string name, const Fx& fx, std::size_t count = 256) {
+			closures.push_back(measure_closure_footprint(std::move(name), fx, count));
+			return *this;
+		}
+
+		const std::vector<usertype_footprint>& usertypes() const {
+			return types;
+		}
+
+		const std::vector<closure_footprint>& functions() const {
+			return closures;
+		}
+
+		void write_table(std::ostream& out) const {
+			out << "bytes per object: measured (requested by sol)\n";
+			if (!types.empty()) {
+				out << std::left << std::setw(32) << "usertype" << std::right
+					<< std::setw(14) << "value" << std::setw(14) << "pointer" << std::setw(14) << "unique"
+					<< std::setw(14) << "registration" << std::setw(10) << "tables" << std::setw(11) << "functions"
+					<< std::setw(10) << "userdata" << std::setw(10) << "strings" << std::setw(10) << "other" << '\n';
+				for (const auto& t : types) {
+					const registration_footprint& r = t.registration;
+					out << std::left << std::setw(32) << t.name << std::right
+						<< std::setw(14) << cell(t.value) << std::setw(14) << cell(t.pointer) << std::setw(14) << cell(t.unique)
+						<< std::setw(14) << r.total << std::setw(10) << r.tables << std::setw(11) << r.functions
+						<< std::setw(10) << r.userdata << std::setw(10) << r.strings << std::setw(10) << r.other << '\n';
+				}
+			}
+			if (!types.empty()) {
+				out << "registration bytes per table, not counting the functions and strings in them\n";
+				out << std::left << std::setw(32) << "usertype" << std::right
+					<< std::setw(16) << "value table" << std::setw(16) << "pointer table" << std::setw(16) << "unique table"
+					<< std::setw(12) << "metabehind" << std::setw(10) << "gc_table" << '\n';
+				for (const auto& t : types) {
+					const registration_tables& r = t.per_table;
+					out << std::left << std::setw(32) << t.name << std::right
+						<< std::setw(16) << r.value_metatable << std::setw(16) << r.pointer_metatable << std::setw(16) << r.unique_metatable
+						<< std::setw(12) << r.metabehind << std::setw(10) << r.gc_table << '\n';
+				}
+			}
+			if (!closures.empty()) {
+				out << std::left << std::setw(32) << "function" << std::right << std::setw(14) << "closure" << '\n';
+				for (const auto& c : closures) {
+					out << std::left << std::setw(32) << c.name << std::right << std::setw(14) << cell(c.closure) << '\n';
+				}
+			}
+		}
+
+		std::string table() const {
+			std::ostringstream out;
+			write_table(out);
+			return out.str();
+		}
+	};
+} // sol
+
+#endif // SOL_MEMORY_FOOTPRINT_HPP
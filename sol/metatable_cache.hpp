@@ -0,0 +1,141 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2016 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_METATABLE_CACHE_HPP
+#define SOL_METATABLE_CACHE_HPP
+
+#include "types.hpp"
+#include "usertype_traits.hpp"
+#include "inheritance.hpp"
+
+namespace sol {
+	namespace detail {
+		// Each state keeps an array of the metatables it has handed out,
+		// indexed by the dense id_for of the type they are named after:
+		// after the first use, finding a type's metatable is a rawgeti
+		// instead of hashing its (long, demangled) name into the registry
+		inline const void* metatable_cache_key() {
+			static const char key = 0;
+			return &key;
+		}
+
+		template <typename T>
+		struct user_gc_metatable_slot {};
+
+		// Usertypes registered lazily map each of their metatable names here
+		// to a function that builds them, until something first asks for one
+		inline const void* lazy_usertypes_key() {
+			static const char key = 0;
+			return &key;
+		}
+
+		inline void build_lazy_usertype(lua_State* L, const char* name) {
+			lua_rawgetp(L, LUA_REGISTRYINDEX, lazy_usertypes_key());
+			if (lua_type(L, -1) != LUA_TTABLE) {
+				lua_pop(L, 1);
+				return;
+			}
+			lua_pushstring(L, name);
+			lua_rawget(L, -2);
+			lua_remove(L, -2);
+			if (lua_type(L, -1) != LUA_TFUNCTION) {
+				lua_pop(L, 1);
+				return;
+			}
+			lua_call(L, 0, 0);
+		}
+
+		inline void push_metatable_cache(lua_State* L) {
+			lua_rawgetp(L, LUA_REGISTRYINDEX, metatable_cache_key());
+			if (lua_type(L, -1) == LUA_TTABLE) {
+				return;
+			}
+			lua_pop(L, 1);
+			lua_createtable(L, 32, 0);
+			lua_pushvalue(L, -1);
+			lua_rawsetp(L, LUA_REGISTRYINDEX, metatable_cache_key());
+		}
+
+		// Leaves the cache on the stack, with the metatable above it if it was found
+		inline bool find_cached_metatable(lua_State* L, std::size_t id) {
+			push_metatable_cache(L);
+			lua_rawgeti(L, -1, static_cast<int>(id));
+			if (lua_type(L, -1) == LUA_TTABLE) {
+				return true;
+			}
+			lua_pop(L, 1);
+			return false;
+		}
+
+		// Pushes the metatable registered under name, or nil if there is none
+		// Misses are not remembered, since the type may be registered later
+		inline bool get_cached_metatable(lua_State* L, std::size_t id, const char* name) {
+			if (find_cached_metatable(L, id)) {
+				lua_remove(L, -2);
+				return true;
+			}
+			build_lazy_usertype(L, name);
+			count_hot_path(L, &hot_path_counters::get_metatables);
+			luaL_getmetatable(L, name);
+			bool found = lua_type(L, -1) == LUA_TTABLE;
+			if (found) {
+				lua_pushvalue(L, -1);
+				lua_rawseti(L, -3, static_cast<int>(id));
+			}
+			lua_remove(L, -2);
+			return found;
+		}
+
+		// Pushes the metatable registered under name, making it if there is none
+		// Returns true only if it was made, so the caller can fill it in
+		inline bool new_cached_metatable(lua_State* L, std::size_t id, const char* name) {
+			if (find_cached_metatable(L, id)) {
+				lua_remove(L, -2);
+				return false;
+			}
+			build_lazy_usertype(L, name);
+			count_hot_path(L, &hot_path_counters::new_metatables);
+			bool created = luaL_newmetatable(L, name) != 0;
+			lua_pushvalue(L, -1);
+			lua_rawseti(L, -3, static_cast<int>(id));
+			lua_remove(L, -2);
+			return created;
+		}
+
+		template <typename T>
+		inline bool get_usertype_metatable(lua_State* L) {
+			return get_cached_metatable(L, id_for<T>::value, &detail::usertype_names<T>::metatable()[0]);
+		}
+
+		template <typename T>
+		inline bool new_usertype_metatable(lua_State* L) {
+			return new_cached_metatable(L, id_for<T>::value, &detail::usertype_names<T>::metatable()[0]);
+		}
+
+		template <typename T>
+		inline bool new_user_gc_metatable(lua_State* L) {
+			return new_cached_metatable(L, id_for<user_gc_metatable_slot<T>>::value, &detail::usertype_names<T>::user_gc_metatable()[0]);
+		}
+	} // detail
+} // sol
+
+#endif // SOL_METATABLE_CACHE_HPP
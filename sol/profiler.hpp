@@ -0,0 +1,313 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2016 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_PROFILER_HPP
+#define SOL_PROFILER_HPP
+
+#include "compatibility.hpp"
+#include "inheritance.hpp"
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <ostream>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+
+namespace sol {
+	// Samples the Lua call stack of a state and accumulates wall time per stack.
+	// Every count_interval VM instructions, the time since the previous sample is charged to
+	// the stack that is running. C functions on that stack (bindings that call back into Lua)
+	// are named after the key sol bound them under, not after the call site.
+	// Output is in the "folded stacks" format read by flamegraph.pl and speedscope, weighted in nanoseconds.
+	class profiler {
+	private:
+		typedef std::chrono::steady_clock clock;
+
+		lua_State* L;
+		int interval;
+		bool running;
+		std::size_t maxdepth;
+		std::uint64_t samplecount;
+		clock::time_point mark;
+		std::unordered_map<std::string, std::uint64_t> stacks;
+
+		static const void* registry_key() {
+			static const char key = 0;
+			return &key;
+		}
+
+		// Weak keyed table of function -> bound name, or false for functions
+		// that were not found the last time the bindings were indexed
+		static const void* names_key() {
+			static const char key = 0;
+			return &key;
+		}
+
+		static void name_function(lua_State* T, int names, const std::string& name, bool replace) {
+			// function on top of the stack
+			lua_pushvalue(T, -1);
+			lua_rawget(T, names);
+			bool named = lua_type(T, -1) == LUA_TSTRING;
+			lua_pop(T, 1);
+			if (named && !replace) {
+				lua_pop(T, 1);
+				return;
+			}
+			lua_pushstring(T, name.c_str());
+			lua_rawset(T, names);
+		}
+
+		// Names the functions of the table on top of the stack: its fields,
+		// and the members a sol usertype keeps in its member lookup
+		static void name_fields(lua_State* T, int names, const std::string& prefix) {
+			int t = lua_gettop(T);
+			lua_pushnil(T);
+			while (lua_next(T, t) != 0) {
+				if (lua_type(T, -1) == LUA_TFUNCTION && lua_type(T, -2) == LUA_TSTRING) {
+					name_function(T, names, prefix + lua_tostring(T, -2), false);
+				}
+				else {
+					lua_pop(T, 1);
+				}
+			}
+			lua_rawgetp(T, t, detail::base_class_member_lookup_key());
+			if (lua_type(T, -1) == LUA_TTABLE) {
+				int lookup = lua_gettop(T);
+				lua_pushnil(T);
+				while (lua_next(T, lookup) != 0) {
+					if (lua_type(T, -1) == LUA_TFUNCTION && lua_type(T, -2) == LUA_TSTRING) {
+						name_function(T, names, prefix + lua_tostring(T, -2), false);
+					}
+					else {
+						lua_pop(T, 1);
+					}
+				}
+			}
+			lua_pop(T, 1);
+		}
+
+		// Walks the globals, and the tables one level below them (libraries and
+		// usertypes), to find the name every bound function was set under
+		static void index_names(lua_State* T, int names) {
+			lua_pushglobaltable(T);
+			int globals = lua_gettop(T);
+			lua_pushnil(T);
+			while (lua_next(T, globals) != 0) {
+				if (lua_type(T, -2) != LUA_TSTRING) {
+					lua_pop(T, 1);
+					continue;
+				}
+				std::string key = lua_tostring(T, -2);
+				switch (lua_type(T, -1)) {
+				case LUA_TFUNCTION:
+					// a global name beats a field name
+					name_function(T, names, key, true);
+					break;
+				case LUA_TTABLE:
+					if (lua_rawequal(T, -1, globals) == 0) {
+						name_fields(T, names, key + ".");
+					}
+					lua_pop(T, 1);
+					break;
+				default:
+					lua_pop(T, 1);
+					break;
+				}
+			}
+			lua_pop(T, 1);
+		}
+
+		static void push_names(lua_State* T) {
+			lua_rawgetp(T, LUA_REGISTRYINDEX, names_key());
+			if (lua_type(T, -1) == LUA_TTABLE) {
+				return;
+			}
+			lua_pop(T, 1);
+			lua_newtable(T);
+			lua_createtable(T, 0, 1);
+			lua_pushliteral(T, "k");
+			lua_setfield(T, -2, "__mode");
+			lua_setmetatable(T, -2);
+			lua_pushvalue(T, -1);
+			lua_rawsetp(T, LUA_REGISTRYINDEX, names_key());
+		}
+
+		// Appends the name the C function of ar was bound under
+		static void append_bound_name(std::string& out, lua_State* T, lua_Debug& ar) {
+			lua_getinfo(T, "f", &ar);
+			int f = lua_gettop(T);
+			push_names(T);
+			int names = f + 1;
+			lua_pushvalue(T, f);
+			lua_rawget(T, names);
+			if (lua_type(T, -1) == LUA_TNIL) {
+				// bound since the last time the names were indexed
+				lua_pop(T, 1);
+				index_names(T, names);
+				lua_pushvalue(T, f);
+				lua_rawget(T, names);
+				if (lua_type(T, -1) == LUA_TNIL) {
+					lua_pushvalue(T, f);
+					lua_pushboolean(T, 0);
+					lua_rawset(T, names);
+				}
+			}
+			out += lua_type(T, -1) == LUA_TSTRING ? lua_tostring(T, -1) : "?";
+			lua_settop(T, f - 1);
+		}
+
+		static void append_label(std::string& out, lua_State* T, lua_Debug& ar) {
+			lua_getinfo(T, "Sn", &ar);
+			std::size_t start = out.size();
+			if (std::strcmp(ar.what, "C") == 0) {
+				out += "[C] ";
+				append_bound_name(out, T, ar);
+			}
+			else if (std::strcmp(ar.what, "main") == 0) {
+				out += "main chunk (";
+				out += ar.short_src;
+				out += ")";
+			}
+			else {
+				out += ar.name != nullptr ? ar.name : "?";
+				out += " (";
+				out += ar.short_src;
+				out += ":";
+				out += std::to_string(ar.linedefined);
+				out += ")";
+			}
+			// ';' separates frames in the output
+			for (std::size_t i = start; i < out.size(); ++i) {
+				if (out[i] == ';') {
+					out[i] = ',';
+				}
+			}
+		}
+
+		std::string capture(lua_State* T) const {
+			std::vector<lua_Debug> frames;
+			lua_Debug ar;
+			for (int level = 0; frames.size() < maxdepth && lua_getstack(T, level, &ar) == 1; ++level) {
+				frames.push_back(ar);
+			}
+			luaL_checkstack(T, 8, "sol: not enough stack space to name a sampled frame");
+			std::string folded;
+			for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+				if (!folded.empty()) {
+					folded += ';';
+				}
+				append_label(folded, T, *it);
+			}
+			return folded;
+		}
+
+		void sample(lua_State* T) {
+			clock::time_point now = clock::now();
+			std::uint64_t elapsed = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - mark).count());
+			std::string folded = capture(T);
+			if (!folded.empty()) {
+				stacks[folded] += elapsed;
+				++samplecount;
+			}
+			// do not count our own bookkeeping
+			mark = clock::now();
+		}
+
+		static void hook(lua_State* T, lua_Debug*) {
+			lua_rawgetp(T, LUA_REGISTRYINDEX, registry_key());
+			profiler* self = static_cast<profiler*>(lua_touserdata(T, -1));
+			lua_pop(T, 1);
+			if (self != nullptr) {
+				self->sample(T);
+			}
+		}
+
+	public:
+		profiler(lua_State* L, int count_interval = 1000, std::size_t max_depth = 128) : L(L), interval(count_interval), running(false), maxdepth(max_depth), samplecount(0) {}
+
+		profiler(const profiler&) = delete;
+		profiler& operator=(const profiler&) = delete;
+
+		~profiler() {
+			stop();
+		}
+
+		// Installs the hook on the state's main thread; coroutines created
+		// afterwards inherit it, but ones that already exist are not sampled
+		void start() {
+			if (running) {
+				return;
+			}
+			lua_pushlightuserdata(L, static_cast<void*>(this));
+			lua_rawsetp(L, LUA_REGISTRYINDEX, registry_key());
+			// bindings may have changed since the last run
+			lua_pushnil(L);
+			lua_rawsetp(L, LUA_REGISTRYINDEX, names_key());
+			mark = clock::now();
+			lua_sethook(L, &hook, LUA_MASKCOUNT, interval);
+			running = true;
+		}
+
+		void stop() {
+			if (!running) {
+				return;
+			}
+			lua_sethook(L, nullptr, 0, 0);
+			lua_pushnil(L);
+			lua_rawsetp(L, LUA_REGISTRYINDEX, registry_key());
+			running = false;
+		}
+
+		bool is_running() const {
+			return running;
+		}
+
+		void clear() {
+			stacks.clear();
+			samplecount = 0;
+		}
+
+		std::uint64_t samples() const {
+			return samplecount;
+		}
+
+		std::map<std::string, std::uint64_t> folded_stacks() const {
+			return std::map<std::string, std::uint64_t>(stacks.begin(), stacks.end());
+		}
+
+		void write_folded(std::ostream& out) const {
+			for (const auto& kvp : folded_stacks()) {
+				out << kvp.first << ' ' << kvp.second << '\n';
+			}
+		}
+
+		std::string folded() const {
+			std::ostringstream out;
+			write_folded(out);
+			return out.str();
+		}
+	};
+} // sol
+
+#endif // SOL_PROFILER_HPP
@@ -25,6 +25,7 @@
 #include "reference.hpp"
 #include "stack.hpp"
 #include "protected_function_result.hpp"
+#include "call_latency.hpp"
 #include <cstdint>
 #include <algorithm>
 
@@ -32,6 +33,10 @@ namespace sol {
 	template <typename base_t>
 	class basic_protected_function : public base_t {
 	private:
+#ifdef SOL_CALL_LATENCY
+		mutable detail::latency_record* latency = nullptr;
+#endif // Call Latency
+
 		static reference& handler_storage() {
 			static sol::reference h;
 			return h;
@@ -157,8 +162,20 @@ namespace sol {
 			return call<Ret...>(std::forward<Args>(args)...);
 		}
 
+		// Records this function's calls under name instead of where it was defined
+		void set_latency_name(const std::string& name) {
+#ifdef SOL_CALL_LATENCY
+			latency = detail::register_latency(base_t::lua_state(), name);
+#else
+			(void)name;
+#endif // Call Latency
+		}
+
 		template<typename... Ret, typename... Args>
 		decltype(auto) call(Args&&... args) const {
+#ifdef SOL_CALL_LATENCY
+			detail::latency_scope latencyscope(*this, latency);
+#endif // Call Latency
 			handler h(error_handler);
 			base_t::push();
 			int pushcount = stack::multi_push_reference(base_t::lua_state(), std::forward<Args>(args)...);
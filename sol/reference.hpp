@@ -72,12 +72,16 @@ namespace sol {
 			if (ref == LUA_NOREF)
 				return LUA_NOREF;
 			push();
+			detail::count_hot_path(L, &hot_path_counters::refs);
+			detail::heap_origin_scope origin(L, "sol: reference");
 			return luaL_ref(L, LUA_REGISTRYINDEX);
 		}
 
 	protected:
 		reference(lua_State* L, detail::global_tag) noexcept : L(L) {
 			lua_pushglobaltable(L);
+			detail::count_hot_path(L, &hot_path_counters::refs);
+			detail::heap_origin_scope origin(L, "sol: reference");
 			ref = luaL_ref(L, LUA_REGISTRYINDEX);
 		}
 
@@ -92,10 +96,13 @@ namespace sol {
 		reference(stack_reference&& r) noexcept : reference(r.lua_state(), r.stack_index()) {}
 		reference(lua_State* L, int index = -1) noexcept : L(L) {
 			lua_pushvalue(L, index);
+			detail::count_hot_path(L, &hot_path_counters::refs);
+			detail::heap_origin_scope origin(L, "sol: reference");
 			ref = luaL_ref(L, LUA_REGISTRYINDEX);
 		}
 
 		virtual ~reference() noexcept {
+			detail::count_hot_path(L, &hot_path_counters::unrefs);
 			luaL_unref(L, LUA_REGISTRYINDEX, ref);
 		}
 
@@ -22,7 +22,7 @@
 #ifndef SOL_SIMPLE_USERTYPE_METATABLE_HPP
 #define SOL_SIMPLE_USERTYPE_METATABLE_HPP
 
-#include "usertype_metatable.hpp"
+#include "erased_usertype_metatable.hpp"
 #include "object.hpp"
 #include <vector>
 #include <utility>
@@ -31,21 +31,107 @@ namespace sol {
 
 	struct simple_tag {} const simple{};
 
+	namespace usertype_detail {
+		// sol::var values are stored in the metatable as they are:
+		// member variables and properties get an accessor instead
+		template <typename F>
+		struct is_simple_variable : meta::all<is_variable_binding<F>, meta::neg<meta::is_specialization_of<var_wrapper, meta::unqualified_t<F>>>> {};
+
+		// Where the member lookup keeps the integer accessors
+		inline const void* simple_integer_access_key(bool is_index) {
+			static const char keys[2] = {};
+			return &keys[is_index ? 0 : 1];
+		}
+
+		// upvalue 1 is the member lookup, upvalue 2 the metatable,
+		// which still holds anything set on it after registration
+		template <bool b, bool dynamic>
+		inline int simple_real_indexing_call(lua_State* L) {
+			if (is_integer_key(L, 2)) {
+				lua_rawgetp(L, upvalue_index(1), simple_integer_access_key(b));
+				if (type_of(L, -1) == type::function) {
+					lua_insert(L, 1);
+					lua_call(L, lua_gettop(L) - 1, b ? 1 : 0);
+					return b ? 1 : 0;
+				}
+				lua_pop(L, 1);
+			}
+			int ret = call_member<b>(L, upvalue_index(1), 2);
+			if (ret > -1) {
+				return ret;
+			}
+			if (b) {
+				lua_pushvalue(L, 2);
+				lua_rawget(L, upvalue_index(2));
+				if (!dynamic || type_of(L, -1) != type::nil) {
+					return 1;
+				}
+				lua_pop(L, 1);
+			}
+			if (dynamic) {
+				ret = dynamic_field<b>(L, false);
+				if (ret > -1) {
+					return ret;
+				}
+			}
+			if (b) {
+				lua_pushnil(L);
+				return 1;
+			}
+			return indexing_fail<false>(L);
+		}
+
+		template <bool b, bool dynamic>
+		inline int simple_indexing_call(lua_State* L) {
+			return detail::static_trampoline<(&simple_real_indexing_call<b, dynamic>)>(L);
+		}
+	} // usertype_detail
+
 	template <typename T>
 	struct simple_usertype_metatable : usertype_detail::registrar {
 		std::vector<std::pair<object, object>> registrations;
+		std::vector<usertype_detail::erased_member> variables;
+		// The same variables as functions, used unless variable_fields is given
+		std::vector<std::pair<object, object>> variablecalls;
 		object callconstructfunc;
+		object integerindexfunc;
+		object integernewindexfunc;
+		bool dynamicfields;
+		bool variablefields;
 		
 		template <typename N, typename F, meta::enable<meta::is_callable<meta::unwrap_unqualified_t<F>>> = meta::enabler>
 		void add(lua_State* L, N&& n, F&& f) {
 			registrations.emplace_back(make_object(L, std::forward<N>(n)), make_object(L, as_function(std::forward<F>(f))));
 		}
 
-		template <typename N, typename F, meta::disable<meta::is_callable<meta::unwrap_unqualified_t<F>>> = meta::enabler>
+		template <typename N, typename F, meta::disable_any<meta::is_callable<meta::unwrap_unqualified_t<F>>, usertype_detail::is_simple_variable<F>> = meta::enabler>
 		void add(lua_State* L, N&& n, F&& f) {
 			registrations.emplace_back(make_object(L, std::forward<N>(n)), make_object(L, std::forward<F>(f)));
 		}
 
+		// Pushed the way the other two add overloads would push it
+		template <typename F>
+		static object make_variable_call(lua_State* L, F&& f, std::true_type) {
+			return make_object(L, as_function(std::forward<F>(f)));
+		}
+
+		template <typename F>
+		static object make_variable_call(lua_State* L, F&& f, std::false_type) {
+			return make_object(L, std::forward<F>(f));
+		}
+
+		template <typename N, typename F, meta::enable<usertype_detail::is_simple_variable<F>> = meta::enabler>
+		void add(lua_State* L, N&& n, F&& f) {
+			typedef std::decay_t<F> Fx;
+			usertype_detail::erased_member m;
+			string_detail::string_shim name = usertype_detail::make_shim(std::forward<N>(n));
+			m.name.assign(name.data(), name.size());
+			m.function = std::make_shared<Fx>(f);
+			usertype_detail::make_erased_entry_points<T, Fx>(m, std::true_type());
+			variablecalls.emplace_back(make_object(L, m.name), make_variable_call(L, std::forward<F>(f), meta::is_callable<meta::unwrap_unqualified_t<F>>()));
+			variables.push_back(std::move(m));
+		}
+
 		template <typename N, typename... Fxs>
 		void add(lua_State* L, N&& n, constructor_wrapper<Fxs...> c) {
 			registrations.emplace_back(make_object(L, std::forward<N>(n)), make_object(L, detail::tagged<T, constructor_wrapper<Fxs...>>{std::move(c)}));
@@ -61,9 +147,27 @@ namespace sol {
 			callconstructfunc = make_object(L, std::forward<F>(f));
 		}
 
+		template <typename F>
+		void add(lua_State* L, integer_index_tag, F&& f) {
+			integerindexfunc = make_object(L, as_function(std::forward<F>(f)));
+		}
+
+		template <typename F>
+		void add(lua_State* L, integer_new_index_tag, F&& f) {
+			integernewindexfunc = make_object(L, as_function(std::forward<F>(f)));
+		}
+
+		void add(lua_State*, dynamic_fields_tag, bool enabled) {
+			dynamicfields = dynamicfields || enabled;
+		}
+
+		void add(lua_State*, variable_fields_tag, bool enabled) {
+			variablefields = variablefields || enabled;
+		}
+
 		template<std::size_t... I, typename Tuple>
 		simple_usertype_metatable(usertype_detail::verified_tag, std::index_sequence<I...>, lua_State* L, Tuple&& args)
-		: callconstructfunc(nil) {
+		: callconstructfunc(nil), integerindexfunc(nil), integernewindexfunc(nil), dynamicfields(false), variablefields(false) {
 			registrations.reserve(std::tuple_size<meta::unqualified_t<Tuple>>::value);
 			(void)detail::swallow{ 0,
 				(add(L, detail::forward_get<I * 2>(args), detail::forward_get<I * 2 + 1>(args)),0)...
@@ -99,6 +203,36 @@ namespace sol {
 		template<typename... Args, typename... Fxs>
 		simple_usertype_metatable(lua_State* L, constructor_wrapper<Fxs...> constructorlist, Args&&... args) : simple_usertype_metatable(L, usertype_detail::check_destructor_tag(), std::forward<Args>(args)..., "new", constructorlist) {}
 
+		// Variables and every named function, keyed by interned name,
+		// so a field access is one rawget from the C __index
+		// The lookup is left on the stack
+		void make_member_lookup(lua_State* L) {
+			lua_createtable(L, 0, static_cast<int>(registrations.size() + variables.size()));
+			int lookup = lua_gettop(L);
+			for (auto& m : variables) {
+				m.variable.data = static_cast<void*>(&m);
+				lua_pushlightuserdata(L, static_cast<void*>(&m.variable));
+				usertype_detail::add_member_lookup(L, lookup, string_detail::string_shim(m.name));
+			}
+			for (auto& kvp : registrations) {
+				if (!kvp.first.template is<std::string>() || kvp.first.template as<std::string>() == name_of(meta_function::garbage_collect)) {
+					continue;
+				}
+				kvp.first.push();
+				kvp.second.push();
+				usertype_detail::add_member_lookup(L, lookup, lua_gettop(L) - 1);
+				lua_pop(L, 1);
+			}
+			if (integerindexfunc.valid()) {
+				integerindexfunc.push();
+				lua_rawsetp(L, lookup, usertype_detail::simple_integer_access_key(true));
+			}
+			if (integernewindexfunc.valid()) {
+				integernewindexfunc.push();
+				lua_rawsetp(L, lookup, usertype_detail::simple_integer_access_key(false));
+			}
+		}
+
 		virtual int push_um(lua_State* L) override {
 			return stack::push(L, std::move(*this));
 		}
@@ -108,60 +242,100 @@ namespace sol {
 		template <typename T>
 		struct pusher<simple_usertype_metatable<T>> {
 			typedef simple_usertype_metatable<T> umt_t;
+
+			static umt_t& make_cleanup(lua_State* L, umt_t&& umx) {
+				// Variables are pointed to by light userdata from here on,
+				// so they have to be in their final place first
+				const char* gcmetakey = &detail::usertype_names<T>::gc_table()[0];
+				stack::push<user<umt_t>>(L, std::move(umx));
+				stack_reference umt(L, -1);
+				stack::set_field<true>(L, gcmetakey, umt);
+				umt.pop();
+
+				stack::get_field<true>(L, gcmetakey);
+				return stack::pop<light<umt_t>>(L);
+			}
 			
 			static int push(lua_State* L, umt_t&& umx) {
-				for (std::size_t i = 0; i < 3; ++i) {
-					// Pointer types, AKA "references" from C++
-					const char* metakey = nullptr;
-					switch (i) {
-					case 0:
-						metakey = &usertype_traits<T*>::metatable[0];
-						break;
-					case 1:
-						metakey = &usertype_traits<detail::unique_usertype<T>>::metatable[0];
-						break;
-					case 2:
-					default:
-						metakey = &usertype_traits<T>::metatable[0];
-						break;
+				detail::heap_origin_scope origin(L, "sol: usertype registration");
+				umt_t& um = make_cleanup(L, std::move(umx));
+				if (!um.variablefields) {
+					// obj:name() gets and obj:name(value) sets
+					for (auto& kvp : um.variablecalls) {
+						um.registrations.push_back(std::move(kvp));
 					}
-					luaL_newmetatable(L, metakey);
-					stack_reference t(L, -1);
-					for (auto& kvp : umx.registrations) {
-						switch (i) {
-						case 0:
-							if (kvp.first.template is<std::string>() && kvp.first.template as<std::string>() == "__gc") {
-								continue;
-							}
-							break;
-						case 1:
-							if (kvp.first.template is<std::string>() && kvp.first.template as<std::string>() == "__gc") {
-								stack::set_field(L, kvp.first, detail::unique_destruct<T>, t.stack_index());
-								continue;
-							}
-							break;
-						case 2:
-						default:
-							break;
-						}
-						stack::set_field(L, kvp.first, kvp.second, t.stack_index());
+					um.variables.clear();
+				}
+				um.variablecalls.clear();
+#ifdef SOL_BINDING_STATS
+				for (auto& m : um.variables) {
+					m.record = detail::register_binding(L, detail::usertype_names<T>::name() + "." + m.name);
+				}
+				for (auto& kvp : um.registrations) {
+					if (!kvp.first.template is<std::string>() || !kvp.second.template is<function>()) {
+						continue;
+					}
+					std::string name = kvp.first.template as<std::string>();
+					if (name == "__gc") {
+						continue;
+					}
+					kvp.second.push();
+					detail::instrument_binding(L, detail::usertype_names<T>::name() + "." + name);
+					kvp.second = object(L, -1);
+					lua_pop(L, 1);
+				}
+#endif // Binding Statistics
+				bool mustindex = !um.variables.empty() || um.dynamicfields || um.integerindexfunc.valid() || um.integernewindexfunc.valid();
+				int lookup = 0;
+				if (mustindex) {
+					um.make_member_lookup(L);
+					lookup = lua_gettop(L);
+				}
+				// The value metatable is also the usertype's table in Lua,
+				// so it is the one that holds every function
+				detail::count_hot_path(L, &hot_path_counters::new_metatables);
+				luaL_newmetatable(L, &detail::usertype_names<T>::metatable()[0]);
+				stack_reference t(L, -1);
+				bool hasdestructor = false;
+				for (auto& kvp : um.registrations) {
+					if (kvp.first.template is<std::string>() && kvp.first.template as<std::string>() == "__gc") {
+						hasdestructor = true;
 					}
+					stack::set_field(L, kvp.first, kvp.second, t.stack_index());
+				}
 
+				if (mustindex) {
+					lua_CFunction indexcall = um.dynamicfields ? usertype_detail::simple_indexing_call<true, true> : usertype_detail::simple_indexing_call<true, false>;
+					lua_CFunction newindexcall = um.dynamicfields ? usertype_detail::simple_indexing_call<false, true> : usertype_detail::simple_indexing_call<false, false>;
+					stack::set_field(L, meta_function::index, make_closure(indexcall, stack_reference(L, lookup), t), t.stack_index());
+					stack::set_field(L, meta_function::new_index, make_closure(newindexcall, stack_reference(L, lookup), t), t.stack_index());
+				}
+				else {
 					// Metatable indexes itself
 					stack::set_field(L, meta_function::index, t, t.stack_index());
+				}
 
-					// metatable on the metatable
-					// for call constructor purposes and such
-					lua_createtable(L, 0, 1);
-					stack_reference metabehind(L, -1);
-					if (umx.callconstructfunc.valid()) {
-						stack::set_field(L, sol::meta_function::call_function, umx.callconstructfunc, metabehind.stack_index());
-					}
-					stack::set_field(L, metatable_key, metabehind, t.stack_index());
-					metabehind.pop();
+				// metatable on the metatable
+				// for call constructor purposes and such
+				lua_createtable(L, 0, 1);
+				stack_reference metabehind(L, -1);
+				if (um.callconstructfunc.valid()) {
+					stack::set_field(L, sol::meta_function::call_function, um.callconstructfunc, metabehind.stack_index());
+				}
+				stack::set_field(L, metatable_key, metabehind, t.stack_index());
+				metabehind.pop();
 
-					if (i < 2)
-						t.pop();
+				// Pointer types, AKA "references" from C++, and unique usertypes
+				// index through the value metatable instead of repeating its functions
+				usertype_detail::new_shared_metatable<T*>(L, t.stack_index());
+				lua_pop(L, 1);
+				int unique = usertype_detail::new_shared_metatable<detail::unique_usertype<T>>(L, t.stack_index());
+				if (hasdestructor) {
+					stack::set_field<false, true>(L, meta_function::garbage_collect, detail::unique_destruct<T>, unique);
+				}
+				lua_pop(L, 1);
+				if (mustindex) {
+					lua_remove(L, lookup);
 				}
 				return 1;
 			}
@@ -102,6 +102,7 @@ namespace sol {
 		template <typename T>
 		int set_ref(lua_State* L, T&& arg, int tableindex = -2) {
 			push(L, std::forward<T>(arg));
+			detail::heap_origin_scope origin(L, "sol: reference");
 			return luaL_ref(L, tableindex);
 		}
 
@@ -182,6 +183,7 @@ namespace sol {
 		}
 
 		inline call_syntax get_call_syntax(lua_State* L, const std::string& key, int index = -2) {
+			detail::count_hot_path(L, &hot_path_counters::get_metatables);
 			luaL_getmetatable(L, key.c_str());
 			auto pn = pop_n(L, 1);
 			if (lua_compare(L, -1, index, LUA_OPEQ) == 1) {
@@ -190,6 +192,16 @@ namespace sol {
 			return call_syntax::dot;
 		}
 
+		template <typename T>
+		inline call_syntax get_call_syntax(lua_State* L, int index = -2) {
+			detail::get_usertype_metatable<T>(L);
+			auto pn = pop_n(L, 1);
+			if (lua_compare(L, -1, index, LUA_OPEQ) == 1) {
+				return call_syntax::colon;
+			}
+			return call_syntax::dot;
+		}
+
 		inline void script(lua_State* L, const std::string& code) {
 			if (luaL_dostring(L, code.c_str())) {
 				lua_error(L);
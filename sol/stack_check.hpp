@@ -34,10 +34,7 @@ namespace sol {
 		namespace stack_detail {
 			template <typename T>
 			inline bool check_metatable(lua_State* L, int index = -2) {
-				const auto& metakey = usertype_traits<T>::metatable;
-				luaL_getmetatable(L, &metakey[0]);
-				const type expectedmetatabletype = static_cast<type>(lua_type(L, -1));
-				if (expectedmetatabletype != type::nil) {
+				if (detail::get_usertype_metatable<T>(L)) {
 					if (lua_rawequal(L, -1, index) == 1) {
 						lua_pop(L, 2);
 						return true;
@@ -47,6 +44,16 @@ namespace sol {
 				return false;
 			}
 
+			template <typename T>
+			inline bool check_container_metatable(lua_State* L, std::true_type) {
+				return check_metatable<detail::container_view<T>>(L) || check_metatable<detail::container_value<T>>(L);
+			}
+
+			template <typename T>
+			inline bool check_container_metatable(lua_State*, std::false_type) {
+				return false;
+			}
+
 			template <type expected, int(*check_func)(lua_State*, int)>
 			struct basic_check {
 				template <typename Handler>
@@ -268,15 +275,14 @@ namespace sol {
 					return true;
 				if (stack_detail::check_metatable<detail::unique_usertype<U>>(L))
 					return true;
+				if (stack_detail::check_container_metatable<U>(L, meta::has_begin_end<U>()))
+					return true;
 				bool success = false;
 				if (detail::has_derived<T>::value) {
 					auto pn = stack::pop_n(L, 1);
-					lua_getfield(L, -1, &detail::base_class_check_key()[0]);
-					if (type_of(L, -1) != type::nil) {
-						void* basecastdata = lua_touserdata(L, -1);
-						detail::inheritance_check_function ic = (detail::inheritance_check_function)basecastdata;
-						success = ic(detail::id_for<T>::value);
-					}
+					lua_rawgetp(L, -1, detail::base_class_table_key());
+					const detail::inheritance_table* it = static_cast<const detail::inheritance_table*>(lua_touserdata(L, -1));
+					success = it != nullptr && it->check(detail::id_for<T>::value);
 				}
 				if (!success) {
 					lua_pop(L, 1);
@@ -26,6 +26,7 @@
 #include "reference.hpp"
 #include "stack_reference.hpp"
 #include "userdata.hpp"
+#include "metatable_cache.hpp"
 #include "tuple.hpp"
 #include "traits.hpp"
 #include "tie.hpp"
@@ -234,7 +235,9 @@ namespace sol {
 
 			template <typename T>
 			inline int alloc_destroy(lua_State* L) {
-				void* rawdata = lua_touserdata(L, upvalue_index(1));
+				// the metatable is shared by every user<T>, so the
+				// object being collected is the argument, not an upvalue
+				void* rawdata = lua_touserdata(L, 1);
 				T* data = static_cast<T*>(rawdata);
 				std::allocator<T> alloc;
 				alloc.destroy(data);
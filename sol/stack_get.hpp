@@ -168,12 +168,8 @@ namespace sol {
 		template<>
 		struct getter<meta_function> {
 			static meta_function get(lua_State *L, int index, record& tracking) {
-				tracking.use(1);
 				const char* name = getter<const char*>{}.get(L, index, tracking);
-				for (std::size_t i = 0; i < meta_function_names.size(); ++i)
-					if (meta_function_names[i] == name)
-						return static_cast<meta_function>(i);
-				return meta_function::construct;
+				return meta_function_of(name);
 			}
 		};
 
@@ -321,12 +317,14 @@ namespace sol {
 			}
 
 			static T* get_no_nil_from(lua_State* L, void* udata, int index, record&) {
-				if (detail::has_derived<T>::value && luaL_getmetafield(L, index, &detail::base_class_cast_key()[0]) != 0) {
-					void* basecastdata = lua_touserdata(L, -1);
-					detail::inheritance_cast_function ic = (detail::inheritance_cast_function)basecastdata;
-					// use the casting function to properly adjust the pointer for the desired T
-					udata = ic(udata, detail::id_for<T>::value);
-					lua_pop(L, 1);
+				if (detail::has_derived<T>::value && lua_getmetatable(L, index) != 0) {
+					lua_rawgetp(L, -1, detail::base_class_table_key());
+					const detail::inheritance_table* it = static_cast<const detail::inheritance_table*>(lua_touserdata(L, -1));
+					if (it != nullptr) {
+						// use the cast table to properly adjust the pointer for the desired T
+						udata = it->cast(udata, detail::id_for<T>::value);
+					}
+					lua_pop(L, 2);
 				}
 				T* obj = static_cast<T*>(udata);
 				return obj;
@@ -25,6 +25,7 @@
 #include "stack_core.hpp"
 #include "raii.hpp"
 #include "optional.hpp"
+#include "accounting_allocator.hpp"
 #include <memory>
 
 namespace sol {
@@ -32,18 +33,24 @@ namespace sol {
 		template<typename T, typename>
 		struct pusher {
 			template <typename K, typename... Args>
-			static int push_keyed(lua_State* L, K&& k, Args&&... args) {
+			static void push_data(lua_State* L, K&& k, Args&&... args) {
 				// Basically, we store all user-data like this:
 				// If it's a movable/copyable value (no std::ref(x)), then we store the pointer to the new
 				// data in the first sizeof(T*) bytes, and then however many bytes it takes to
 				// do the actual object. Things that are std::ref or plain T* are stored as 
 				// just the sizeof(T*), and nothing else.
-				T** pointerpointer = static_cast<T**>(lua_newuserdata(L, sizeof(T*) + sizeof(T)));
+				T** pointerpointer = static_cast<T**>(detail::usertype_newuserdata(L, sizeof(T*) + sizeof(T), k));
 				T*& referencereference = *pointerpointer;
 				T* allocationtarget = reinterpret_cast<T*>(pointerpointer + 1);
 				referencereference = allocationtarget;
 				std::allocator<T> alloc{};
 				alloc.construct(allocationtarget, std::forward<Args>(args)...);
+			}
+
+			template <typename K, typename... Args>
+			static int push_keyed(lua_State* L, K&& k, Args&&... args) {
+				push_data(L, k, std::forward<Args>(args)...);
+				detail::count_hot_path(L, &hot_path_counters::new_metatables);
 				luaL_newmetatable(L, &k[0]);
 				lua_setmetatable(L, -2);
 				return 1;
@@ -51,25 +58,40 @@ namespace sol {
 
 			template <typename... Args>
 			static int push(lua_State* L, Args&&... args) {
-				return push_keyed(L, usertype_traits<T>::metatable, std::forward<Args>(args)...);
+				push_data(L, detail::usertype_names<T>::metatable(), std::forward<Args>(args)...);
+				detail::new_usertype_metatable<T>(L);
+				lua_setmetatable(L, -2);
+				return 1;
 			}
 		};
 
 		template<typename T>
 		struct pusher<T*> {
+			template <typename K>
+			static void push_data(lua_State* L, K&& k, T* obj) {
+				T** pref = static_cast<T**>(detail::usertype_newuserdata(L, sizeof(T*), k));
+				*pref = obj;
+			}
+
 			template <typename K>
 			static int push_keyed(lua_State* L, K&& k, T* obj) {
 				if (obj == nullptr)
 					return stack::push(L, nil);
-				T** pref = static_cast<T**>(lua_newuserdata(L, sizeof(T*)));
-				*pref = obj;
+				push_data(L, k, obj);
+				detail::count_hot_path(L, &hot_path_counters::new_metatables);
 				luaL_newmetatable(L, &k[0]);
 				lua_setmetatable(L, -2);
 				return 1;
 			}
 
 			static int push(lua_State* L, T* obj) {
-				return push_keyed(L, usertype_traits<meta::unqualified_t<T>*>::metatable, obj);
+				typedef meta::unqualified_t<T>* U;
+				if (obj == nullptr)
+					return stack::push(L, nil);
+				push_data(L, detail::usertype_names<U>::metatable(), obj);
+				detail::new_usertype_metatable<U>(L);
+				lua_setmetatable(L, -2);
+				return 1;
 			}
 		};
 
@@ -100,13 +122,14 @@ namespace sol {
 
 			template <typename... Args>
 			static int push_deep(lua_State* L, Args&&... args) {
-				P** pref = static_cast<P**>(lua_newuserdata(L, sizeof(P*) + sizeof(detail::special_destruct_func) + sizeof(Real)));
+				const auto& metakey = detail::usertype_names<detail::unique_usertype<P>>::metatable();
+				P** pref = static_cast<P**>(detail::usertype_newuserdata(L, sizeof(P*) + sizeof(detail::special_destruct_func) + sizeof(Real), metakey));
 				detail::special_destruct_func* fx = static_cast<detail::special_destruct_func*>(static_cast<void*>(pref + 1));
 				Real* mem = static_cast<Real*>(static_cast<void*>(fx + 1));
 				*fx = detail::special_destruct<P, Real>;
 				detail::default_construct::construct(mem, std::forward<Args>(args)...);
 				*pref = unique_usertype_traits<T>::get(*mem);
-				if (luaL_newmetatable(L, &usertype_traits<detail::unique_usertype<P>>::metatable[0]) == 1) {
+				if (detail::new_usertype_metatable<detail::unique_usertype<P>>(L)) {
 					set_field(L, "__gc", detail::unique_destruct<P>);
 				}
 				lua_setmetatable(L, -2);
@@ -158,6 +181,7 @@ namespace sol {
 		template<typename T>
 		struct pusher<T, std::enable_if_t<meta::all<meta::has_begin_end<T>, meta::neg<meta::has_key_value_pair<T>>, meta::neg<meta::any<std::is_base_of<reference, T>, std::is_base_of<stack_reference, T>>>>::value>> {
 			static int push(lua_State* L, const T& cont) {
+				detail::heap_origin_scope origin(L, "sol: container table");
 				lua_createtable(L, static_cast<int>(cont.size()), 0);
 				int tableindex = lua_gettop(L);
 				unsigned index = 1;
@@ -171,6 +195,7 @@ namespace sol {
 		template<typename T>
 		struct pusher<T, std::enable_if_t<meta::all<meta::has_begin_end<T>, meta::has_key_value_pair<T>, meta::neg<meta::any<std::is_base_of<reference, T>, std::is_base_of<stack_reference, T>>>>::value>> {
 			static int push(lua_State* L, const T& cont) {
+				detail::heap_origin_scope origin(L, "sol: container table");
 				lua_createtable(L, static_cast<int>(cont.size()), 0);
 				int tableindex = lua_gettop(L);
 				for (auto&& pair : cont) {
@@ -282,17 +307,17 @@ namespace sol {
 			template <bool with_meta = true, typename... Args>
 			static int push_with(lua_State* L, Args&&... args) {
 				// A dumb pusher
+				detail::count_hot_path(L, &hot_path_counters::new_userdata);
+				detail::heap_origin_scope origin(L, "sol: user<T> userdata");
 				void* rawdata = lua_newuserdata(L, sizeof(T));
 				T* data = static_cast<T*>(rawdata);
 				std::allocator<T> alloc;
 				alloc.construct(data, std::forward<Args>(args)...);
 				if (with_meta) {
-					const auto name = &usertype_traits<meta::unqualified_t<T>>::user_gc_metatable[0];
 					lua_CFunction cdel = stack_detail::alloc_destroy<T>;
 					// Make sure we have a plain GC set for this data
-					if (luaL_newmetatable(L, name) != 0) {
-						lua_pushlightuserdata(L, rawdata);
-						lua_pushcclosure(L, cdel, 1);
+					if (detail::new_user_gc_metatable<meta::unqualified_t<T>>(L)) {
+						lua_pushcclosure(L, cdel, 0);
 						lua_setfield(L, -2, "__gc");
 					}
 					lua_setmetatable(L, -2);
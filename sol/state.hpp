@@ -52,6 +52,12 @@ namespace sol {
 			stack::luajit_exception_handler(unique_base::get());
 		}
 
+		state(accounting_allocator& allocator, lua_CFunction panic = default_at_panic) : state(panic, &accounting_allocator::allocate, &allocator) {}
+
+		state(heap_profiler& profiler, lua_CFunction panic = default_at_panic) : state(panic, &heap_profiler::allocate, &profiler) {
+			profiler.attach(unique_base::get());
+		}
+
 		using state_view::get;
 	};
 } // sol
@@ -283,6 +283,30 @@ namespace sol {
 			lua_atpanic(L, panic);
 		}
 
+		binding_stats_table binding_stats() const {
+			return sol::binding_stats(L);
+		}
+
+		void reset_binding_stats() {
+			sol::reset_binding_stats(L);
+		}
+
+		hot_path_counters hot_path_snapshot() const {
+			return sol::hot_path_snapshot(L);
+		}
+
+		void reset_hot_path_counters() {
+			sol::reset_hot_path_counters(L);
+		}
+
+		call_latency_table call_latencies() const {
+			return sol::call_latencies(L);
+		}
+
+		void reset_call_latencies() {
+			sol::reset_call_latencies(L);
+		}
+
 		template<typename... Args, typename... Keys>
 		decltype(auto) get(Keys&&... keys) const {
 			return global.get<Args...>(std::forward<Keys>(keys)...);
@@ -317,7 +341,7 @@ namespace sol {
 
 		template<typename T>
 		state_view& set_usertype(usertype<T>& user) {
-			return set_usertype(usertype_traits<T>::name, user);
+			return set_usertype(detail::usertype_names<T>::name(), user);
 		}
 
 		template<typename Key, typename T>
@@ -362,6 +386,48 @@ namespace sol {
 			return *this;
 		}
 
+		template<typename Class, typename... Args>
+		state_view& new_erased_usertype(const std::string& name, Args&&... args) {
+			global.new_erased_usertype<Class>(name, std::forward<Args>(args)...);
+			return *this;
+		}
+
+		template<typename Class, typename CTor0, typename... CTor, typename... Args>
+		state_view& new_erased_usertype(const std::string& name, Args&&... args) {
+			global.new_erased_usertype<Class, CTor0, CTor...>(name, std::forward<Args>(args)...);
+			return *this;
+		}
+
+		template<typename Class, typename... CArgs, typename... Args>
+		state_view& new_erased_usertype(const std::string& name, constructors<CArgs...> ctor, Args&&... args) {
+			global.new_erased_usertype<Class>(name, ctor, std::forward<Args>(args)...);
+			return *this;
+		}
+
+		template<typename T>
+		state_view& set_lazy_usertype(const std::string& key, usertype<T>& user) {
+			global.set_lazy_usertype(key, user);
+			return *this;
+		}
+
+		template<typename Class, typename... Args>
+		state_view& new_lazy_usertype(const std::string& name, Args&&... args) {
+			global.new_lazy_usertype<Class>(name, std::forward<Args>(args)...);
+			return *this;
+		}
+
+		template<typename Class, typename CTor0, typename... CTor, typename... Args>
+		state_view& new_lazy_usertype(const std::string& name, Args&&... args) {
+			global.new_lazy_usertype<Class, CTor0, CTor...>(name, std::forward<Args>(args)...);
+			return *this;
+		}
+
+		template<typename Class, typename... CArgs, typename... Args>
+		state_view& new_lazy_usertype(const std::string& name, constructors<CArgs...> ctor, Args&&... args) {
+			global.new_lazy_usertype<Class>(name, ctor, std::forward<Args>(args)...);
+			return *this;
+		}
+
 		template<bool read_only = true, typename... Args>
 		state_view& new_enum(const std::string& name, Args&&... args) {
 			global.new_enum<read_only>(name, std::forward<Args>(args)...);
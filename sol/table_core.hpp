@@ -26,6 +26,7 @@
 #include "stack.hpp"
 #include "function_types.hpp"
 #include "usertype.hpp"
+#include "container_usertype.hpp"
 #include "table_iterator.hpp"
 
 namespace sol {
@@ -244,7 +245,7 @@ namespace sol {
 
 		template<typename T>
 		basic_table_core& set_usertype(usertype<T>& user) {
-			return set_usertype(usertype_traits<T>::name, user);
+			return set_usertype(detail::usertype_names<T>::name(), user);
 		}
 
 		template<typename Key, typename T>
@@ -292,6 +293,61 @@ namespace sol {
 			return *this;
 		}
 
+		template<typename Class, typename... Args>
+		basic_table_core& new_erased_usertype(const std::string& name, Args&&... args) {
+			usertype<Class> utype(erased, std::forward<Args>(args)...);
+			set_usertype(name, utype);
+			return *this;
+		}
+
+		template<typename Class, typename CTor0, typename... CTor, typename... Args>
+		basic_table_core& new_erased_usertype(const std::string& name, Args&&... args) {
+			constructors<types<CTor0, CTor...>> ctor{};
+			return new_erased_usertype<Class>(name, ctor, std::forward<Args>(args)...);
+		}
+
+		template<typename Class, typename... CArgs, typename... Args>
+		basic_table_core& new_erased_usertype(const std::string& name, constructors<CArgs...> ctor, Args&&... args) {
+			usertype<Class> utype(erased, ctor, std::forward<Args>(args)...);
+			set_usertype(name, utype);
+			return *this;
+		}
+
+		template<typename T>
+		basic_table_core& set_lazy_usertype(const std::string& key, usertype<T>& user) {
+			lua_State* L = base_t::lua_state();
+			// Once the metatables exist there is nothing left to defer
+			if (detail::get_usertype_metatable<T>(L)) {
+				lua_pop(L, 1);
+				return set_usertype(key, user);
+			}
+			lua_pop(L, 1);
+			base_t::push();
+			reference target(L, -1);
+			lua_pop(L, 1);
+			return set(key, user.make_lazy(std::move(target), key));
+		}
+
+		template<typename Class, typename... Args>
+		basic_table_core& new_lazy_usertype(const std::string& name, Args&&... args) {
+			usertype<Class> utype(std::forward<Args>(args)...);
+			set_lazy_usertype(name, utype);
+			return *this;
+		}
+
+		template<typename Class, typename CTor0, typename... CTor, typename... Args>
+		basic_table_core& new_lazy_usertype(const std::string& name, Args&&... args) {
+			constructors<types<CTor0, CTor...>> ctor{};
+			return new_lazy_usertype<Class>(name, ctor, std::forward<Args>(args)...);
+		}
+
+		template<typename Class, typename... CArgs, typename... Args>
+		basic_table_core& new_lazy_usertype(const std::string& name, constructors<CArgs...> ctor, Args&&... args) {
+			usertype<Class> utype(ctor, std::forward<Args>(args)...);
+			set_lazy_usertype(name, utype);
+			return *this;
+		}
+
 		template<bool read_only = true, typename... Args>
 		basic_table_core& new_enum(const std::string& name, Args&&... args) {
 			if (read_only) {
@@ -341,13 +397,15 @@ namespace sol {
 
 		template<typename Sig, typename Key, typename... Args>
 		basic_table_core& set_function(Key&& key, Args&&... args) {
-			set_fx(types<Sig>(), std::forward<Key>(key), std::forward<Args>(args)...);
+			set_fx(types<Sig>(), key, std::forward<Args>(args)...);
+			instrument_function(std::forward<Key>(key));
 			return *this;
 		}
 
 		template<typename Key, typename... Args>
 		basic_table_core& set_function(Key&& key, Args&&... args) {
-			set_fx(types<>(), std::forward<Key>(key), std::forward<Args>(args)...);
+			set_fx(types<>(), key, std::forward<Args>(args)...);
+			instrument_function(std::forward<Key>(key));
 			return *this;
 		}
 
@@ -361,6 +419,28 @@ namespace sol {
 		}
 
 	private:
+#ifdef SOL_BINDING_STATS
+		template<typename Key>
+		void instrument_function(Key&& key) {
+			lua_State* L = base_t::lua_state();
+			auto pp = stack::push_pop<is_global<Key>::value>(*this);
+			int tableindex = lua_gettop(L);
+			stack::push(L, key);
+			optional<std::string> name = stack::check_get<std::string>(L, -1);
+			lua_pop(L, 1);
+			if (!name) {
+				return;
+			}
+			stack::get_field<top_level>(L, key, tableindex);
+			detail::instrument_binding(L, name.value());
+			stack::set_field<top_level>(L, std::forward<Key>(key), stack_reference(L, -1), tableindex);
+			lua_pop(L, 1);
+		}
+#else
+		template<typename Key>
+		void instrument_function(Key&&) {}
+#endif // Binding Statistics
+
 		template<typename R, typename... Args, typename Fx, typename Key, typename = std::result_of_t<Fx(Args...)>>
 		void set_fx(types<R(Args...)>, Key&& key, Fx&& fx) {
 			set_resolved_function<R(Args...)>(std::forward<Key>(key), std::forward<Fx>(fx));
@@ -26,8 +26,13 @@
 #include "compatibility.hpp"
 #include "traits.hpp"
 #include "string_shim.hpp"
+#include "binding_stats.hpp"
+#include "hot_path_counters.hpp"
+#include "heap_profiler.hpp"
 #include <array>
 #include <string>
+#include <cstring>
+#include <initializer_list>
 
 namespace sol {
 	namespace detail {
@@ -88,6 +93,14 @@ namespace sol {
 		template <typename T>
 		struct unique_usertype {};
 
+		// Containers pushed with as_container get metatables of their own,
+		// since T and T* may also be registered as ordinary usertypes
+		template <typename T>
+		struct container_view {};
+
+		template <typename T>
+		struct container_value {};
+
 		template <typename T>
 		struct implicit_wrapper {
 			T& item;
@@ -343,12 +356,31 @@ namespace sol {
 
 	typedef meta_function meta_method;
 
-	const std::array<std::string, 2> meta_variable_names = { {
+	// Given to a usertype as a key with true as its value, lets Lua
+	// set and read fields the usertype does not have on each instance
+	struct dynamic_fields_tag {};
+	const auto dynamic_fields = dynamic_fields_tag{};
+
+	// Given to a simple usertype as a key with true as its value, binds its
+	// member variables and properties as fields instead of as functions
+	struct variable_fields_tag {};
+	const auto variable_fields = variable_fields_tag{};
+
+	// Keys for a usertype's accessors of whole number keys, such as
+	// a (T&, std::size_t) getter and a (T&, std::size_t, V) setter
+	struct integer_index_tag {};
+	const auto integer_index = integer_index_tag{};
+	struct integer_new_index_tag {};
+	const auto integer_new_index = integer_new_index_tag{};
+
+	// Plain character arrays, so that no strings are built
+	// during static initialization of every translation unit
+	constexpr std::array<const char*, 2> meta_variable_names = { {
 		"__index",
 		"__newindex",
 	} };
 
-	const std::array<std::string, 21> meta_function_names = { {
+	constexpr std::array<const char*, 20> meta_function_names = { {
 		"new",
 		"__index",
 		"__newindex",
@@ -371,8 +403,68 @@ namespace sol {
 		"__gc",
 	} };
 
+	namespace detail {
+		struct meta_function_strings {
+			std::array<std::string, meta_function_names.size()> names;
+
+			meta_function_strings() {
+				for (std::size_t i = 0; i < names.size(); ++i) {
+					names[i] = meta_function_names[i];
+				}
+			}
+		};
+
+		inline meta_function first_meta_function_named(const char* name, std::initializer_list<meta_function> candidates) {
+			for (meta_function mf : candidates) {
+				if (std::strcmp(name, meta_function_names[static_cast<std::size_t>(mf)]) == 0) {
+					return mf;
+				}
+			}
+			return meta_function::construct;
+		}
+	} // detail
+
 	inline const std::string& name_of(meta_function mf) {
-		return meta_function_names[static_cast<int>(mf)];
+		static const detail::meta_function_strings strings;
+		return strings.names[static_cast<std::size_t>(mf)];
+	}
+
+	// Unknown names give back meta_function::construct
+	inline meta_function meta_function_of(const char* name) {
+		if (name == nullptr || name[0] != '_' || name[1] != '_') {
+			return meta_function::construct;
+		}
+		// The letter after the "__" leaves at most four names to compare against
+		switch (name[2]) {
+		case 'i':
+			return detail::first_meta_function_named(name, { meta_function::index });
+		case 'n':
+			return detail::first_meta_function_named(name, { meta_function::new_index });
+		case 'm':
+			return detail::first_meta_function_named(name, { meta_function::mode, meta_function::metatable, meta_function::multiplication, meta_function::modulus });
+		case 'c':
+			return detail::first_meta_function_named(name, { meta_function::call, meta_function::concatenation });
+		case 't':
+			return detail::first_meta_function_named(name, { meta_function::to_string });
+		case 'l':
+			return detail::first_meta_function_named(name, { meta_function::length, meta_function::less_than, meta_function::less_than_or_equal_to });
+		case 'u':
+			return detail::first_meta_function_named(name, { meta_function::unary_minus });
+		case 'a':
+			return detail::first_meta_function_named(name, { meta_function::addition });
+		case 's':
+			return detail::first_meta_function_named(name, { meta_function::subtraction });
+		case 'd':
+			return detail::first_meta_function_named(name, { meta_function::division });
+		case 'p':
+			return detail::first_meta_function_named(name, { meta_function::power_of });
+		case 'e':
+			return detail::first_meta_function_named(name, { meta_function::equal_to });
+		case 'g':
+			return detail::first_meta_function_named(name, { meta_function::garbage_collect });
+		default:
+			return meta_function::construct;
+		}
 	}
 
 	inline type type_of(lua_State* L, int index) {
@@ -380,6 +472,7 @@ namespace sol {
 	}
 
 	inline int type_panic(lua_State* L, int index, type expected, type actual) {
+		detail::binding_argument_failure(L);
 		return luaL_error(L, "stack index %d, expected %s, received %s", index,
 			expected == type::poly ? "anything" : lua_typename(L, static_cast<int>(expected)),
 			expected == type::poly ? "anything" : lua_typename(L, static_cast<int>(actual))
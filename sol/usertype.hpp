@@ -25,10 +25,112 @@
 #include "stack.hpp"
 #include "usertype_metatable.hpp"
 #include "simple_usertype_metatable.hpp"
+#include "erased_usertype_metatable.hpp"
 #include <memory>
+#include <string>
 
 namespace sol {
 
+	namespace usertype_detail {
+		// A usertype whose metatables are only built the first time they are
+		// needed: when its table is touched from Lua, or when a value of it is
+		// pushed or checked. Until then its name holds an empty stand-in table
+		struct lazy_usertype {
+			std::unique_ptr<registrar, detail::deleter> blueprint;
+			const std::string* metatables[3];
+			reference target;
+			std::string key;
+			reference stub;
+			reference built;
+
+			void build(lua_State* L) {
+				if (!blueprint) {
+					return;
+				}
+				std::unique_ptr<registrar, detail::deleter> b = std::move(blueprint);
+				lua_rawgetp(L, LUA_REGISTRYINDEX, detail::lazy_usertypes_key());
+				for (const std::string* name : metatables) {
+					lua_pushlstring(L, name->data(), name->size());
+					lua_pushnil(L);
+					lua_rawset(L, -3);
+				}
+				lua_pop(L, 1);
+
+				b->push_um(L);
+				built = reference(L, -1);
+				// Whoever already holds the stand-in keeps working through it,
+				// but the name leads straight to the real table from now on
+				target.push();
+				lua_pushlstring(L, key.data(), key.size());
+				lua_rawget(L, -2);
+				stub.push();
+				bool stubbed = lua_rawequal(L, -1, -2) == 1;
+				lua_pop(L, 2);
+				if (stubbed) {
+					lua_pushlstring(L, key.data(), key.size());
+					lua_pushvalue(L, -3);
+					lua_settable(L, -3);
+				}
+				lua_pop(L, 2);
+				target = reference();
+				stub = reference();
+			}
+		};
+
+		inline lazy_usertype& lazy_upvalue(lua_State* L) {
+			return *static_cast<lazy_usertype*>(lua_touserdata(L, upvalue_index(1)));
+		}
+
+		inline int lazy_real_build(lua_State* L) {
+			lazy_upvalue(L).build(L);
+			return 0;
+		}
+
+		inline int lazy_real_index(lua_State* L) {
+			lazy_usertype& lu = lazy_upvalue(L);
+			lu.build(L);
+			lu.built.push();
+			lua_pushvalue(L, 2);
+			lua_gettable(L, -2);
+			return 1;
+		}
+
+		inline int lazy_real_new_index(lua_State* L) {
+			lazy_usertype& lu = lazy_upvalue(L);
+			lu.build(L);
+			lu.built.push();
+			lua_pushvalue(L, 2);
+			lua_pushvalue(L, 3);
+			lua_settable(L, -3);
+			return 0;
+		}
+
+		inline int lazy_real_call(lua_State* L) {
+			lazy_usertype& lu = lazy_upvalue(L);
+			lu.build(L);
+			lu.built.push();
+			lua_replace(L, 1);
+			lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);
+			return lua_gettop(L);
+		}
+
+		inline int lazy_build(lua_State* L) {
+			return detail::static_trampoline<(&lazy_real_build)>(L);
+		}
+
+		inline int lazy_index(lua_State* L) {
+			return detail::static_trampoline<(&lazy_real_index)>(L);
+		}
+
+		inline int lazy_new_index(lua_State* L) {
+			return detail::static_trampoline<(&lazy_real_new_index)>(L);
+		}
+
+		inline int lazy_call(lua_State* L) {
+			return detail::static_trampoline<(&lazy_real_call)>(L);
+		}
+	} // usertype_detail
+
 	template<typename T>
 	class usertype {
 	private:
@@ -57,9 +159,25 @@ namespace sol {
 		template<typename... Args>
 		usertype(simple_tag, lua_State* L, Args&&... args) : metatableregister(detail::make_unique_deleter<simple_usertype_metatable<T>, detail::deleter>(L, std::forward<Args>(args)...)) {}
 
+		template<typename... Args>
+		usertype(erased_tag, Args&&... args) : metatableregister(detail::make_unique_deleter<erased_usertype_metatable<T>, detail::deleter>(std::forward<Args>(args)...)) {}
+
 		int push(lua_State* L) {
 			return metatableregister->push_um(L);
 		}
+
+		// Hands the blueprint over to be built on first use,
+		// after which it will be set as target[key]
+		usertype_detail::lazy_usertype make_lazy(reference target, std::string key) {
+			usertype_detail::lazy_usertype lu;
+			lu.blueprint = std::move(metatableregister);
+			lu.metatables[0] = &detail::usertype_names<T>::metatable();
+			lu.metatables[1] = &detail::usertype_names<T*>::metatable();
+			lu.metatables[2] = &detail::usertype_names<detail::unique_usertype<T>>::metatable();
+			lu.target = std::move(target);
+			lu.key = std::move(key);
+			return lu;
+		}
 	};
 
 	namespace stack {
@@ -69,6 +187,49 @@ namespace sol {
 				return user.push(L);
 			}
 		};
+
+		template<>
+		struct pusher<usertype_detail::lazy_usertype> {
+			// Pushes the stand-in table, and leaves a builder
+			// behind for each of the usertype's metatables
+			static int push(lua_State* L, usertype_detail::lazy_usertype&& lu) {
+				detail::heap_origin_scope origin(L, "sol: usertype registration");
+				stack::push<user<usertype_detail::lazy_usertype>>(L, std::move(lu));
+				int blueprint = lua_gettop(L);
+				usertype_detail::lazy_usertype& stored = *static_cast<usertype_detail::lazy_usertype*>(lua_touserdata(L, blueprint));
+
+				lua_rawgetp(L, LUA_REGISTRYINDEX, detail::lazy_usertypes_key());
+				if (lua_type(L, -1) != LUA_TTABLE) {
+					lua_pop(L, 1);
+					lua_newtable(L);
+					lua_pushvalue(L, -1);
+					lua_rawsetp(L, LUA_REGISTRYINDEX, detail::lazy_usertypes_key());
+				}
+				for (const std::string* name : stored.metatables) {
+					lua_pushlstring(L, name->data(), name->size());
+					lua_pushvalue(L, blueprint);
+					lua_pushcclosure(L, usertype_detail::lazy_build, 1);
+					lua_rawset(L, -3);
+				}
+				lua_pop(L, 1);
+
+				lua_newtable(L);
+				lua_createtable(L, 0, 3);
+				lua_pushvalue(L, blueprint);
+				lua_pushcclosure(L, usertype_detail::lazy_index, 1);
+				lua_setfield(L, -2, "__index");
+				lua_pushvalue(L, blueprint);
+				lua_pushcclosure(L, usertype_detail::lazy_new_index, 1);
+				lua_setfield(L, -2, "__newindex");
+				lua_pushvalue(L, blueprint);
+				lua_pushcclosure(L, usertype_detail::lazy_call, 1);
+				lua_setfield(L, -2, "__call");
+				lua_setmetatable(L, -2);
+				stored.stub = reference(L, -1);
+				lua_remove(L, blueprint);
+				return 1;
+			}
+		};
 	} // stack
 } // sol
 
@@ -27,10 +27,12 @@
 #include "stack.hpp"
 #include "types.hpp"
 #include "stack_reference.hpp"
+#include "reference.hpp"
 #include "usertype_traits.hpp"
 #include "inheritance.hpp"
 #include "raii.hpp"
 #include "deprecate.hpp"
+#include <cstring>
 
 namespace sol {
 
@@ -51,6 +53,18 @@ namespace sol {
 			return false;
 		}
 
+		inline bool is_indexer(dynamic_fields_tag) {
+			return false;
+		}
+
+		inline bool is_indexer(integer_index_tag) {
+			return false;
+		}
+
+		inline bool is_indexer(integer_new_index_tag) {
+			return false;
+		}
+
 		inline auto make_shim(string_detail::string_shim s) {
 			return s;
 		}
@@ -63,8 +77,12 @@ namespace sol {
 			return string_detail::string_shim(name_of(mf));
 		}
 
-		inline auto make_shim(base_classes_tag) {
-			return string_detail::string_shim(detail::base_class_cast_key());
+		inline auto make_shim(integer_index_tag) {
+			return string_detail::string_shim("integer_index");
+		}
+
+		inline auto make_shim(integer_new_index_tag) {
+			return string_detail::string_shim("integer_new_index");
 		}
 
 		template <typename N>
@@ -88,6 +106,257 @@ namespace sol {
 				return luaL_error(L, "sol: attempt to index (set) nil value \"%s\" on userdata (bad (misspelled?) key name or does not exist)", accessor.data());
 		}
 
+		typedef void (*base_walk)(lua_State*, bool&, int&, string_detail::string_shim&);
+
+		// A variable as seen from a member lookup table: data is whatever
+		// the usertype metatable that registered it needs to find it again
+		struct variable_entry {
+			void* data;
+			int (*index)(lua_State*, void*);
+			int (*new_index)(lua_State*, void*);
+		};
+
+		// Members are found through a Lua table keyed by name, so a lookup is
+		// one rawget hashed on the already-interned key instead of a string
+		// compare against every registered name. Functions map to a closure
+		// made once at registration, variables to a light variable_entry.
+		// Expects the value on top of the stack, and pops it
+		inline void add_member_lookup(lua_State* L, int lookup, int name) {
+			lua_pushvalue(L, name);
+			lua_rawget(L, lookup);
+			bool taken = type_of(L, -1) != type::nil;
+			lua_pop(L, 1);
+			if (taken) {
+				// the first registration of a name wins
+				lua_pop(L, 1);
+				return;
+			}
+			lua_pushvalue(L, name);
+			lua_insert(L, -2);
+			lua_rawset(L, lookup);
+		}
+
+		inline void add_member_lookup(lua_State* L, int lookup, string_detail::string_shim name) {
+			lua_pushlstring(L, name.data(), name.size());
+			lua_insert(L, -2);
+			add_member_lookup(L, lookup, lua_gettop(L) - 1);
+			lua_pop(L, 1);
+		}
+
+		// Copies the lookup table of every base that is already registered
+		// into the derived one, so inherited members are found in one rawget.
+		// The lookups of the bases already hold their own bases' members.
+		// The copied entries point into the base's usertype userdata, so the
+		// lookup also keeps that userdata, under a light key of its own: if the
+		// base is registered again, the old one lives as long as its copies
+		template <typename Base>
+		inline void flatten_base(lua_State* L, int lookup) {
+			if (!detail::get_usertype_metatable<Base>(L)) {
+				lua_pop(L, 1);
+				return;
+			}
+			lua_rawgetp(L, -1, detail::base_class_member_lookup_key());
+			if (type_of(L, -1) != type::table) {
+				lua_pop(L, 2);
+				return;
+			}
+			lua_pushnil(L);
+			while (lua_next(L, -2) != 0) {
+				add_member_lookup(L, lookup, lua_gettop(L) - 1);
+			}
+			lua_pop(L, 2);
+			const std::string& gcmetakey = detail::usertype_names<Base>::gc_table();
+			stack::get_field<true>(L, &gcmetakey[0]);
+			lua_rawsetp(L, lookup, &gcmetakey);
+		}
+
+		template <typename... Bases>
+		inline void flatten_bases(lua_State* L, int lookup) {
+			(void)L;
+			(void)lookup;
+			(void)detail::swallow{ 0, (flatten_base<Bases>(L, lookup), 0)... };
+		}
+
+		typedef void(*base_flatten)(lua_State*, int);
+
+		// Makes the metatable of U, a pointer or unique usertype, share the value
+		// metatable at index from: it gets the closures of the metamethods, which Lua
+		// looks up raw, and sol's own slots. Its __index and __newindex are the value
+		// metatable's, so every other member is found through them. __gc is left out,
+		// since each of the three metatables destroys its userdata differently
+		// Returns where the new metatable is on the stack
+		template <typename U>
+		inline int new_shared_metatable(lua_State* L, int from) {
+			detail::count_hot_path(L, &hot_path_counters::new_metatables);
+			luaL_newmetatable(L, &detail::usertype_names<U>::metatable()[0]);
+			int to = lua_gettop(L);
+			lua_pushnil(L);
+			while (lua_next(L, from) != 0) {
+				bool shared = false;
+				switch (type_of(L, -2)) {
+				case type::lightuserdata:
+					shared = true;
+					break;
+				case type::string: {
+					std::size_t len;
+					const char* name = lua_tolstring(L, -2, &len);
+					shared = len > 2 && name[0] == '_' && name[1] == '_'
+						&& name != name_of(meta_function::garbage_collect)
+						&& std::strcmp(name, "__name") != 0;
+					break;
+				}
+				default:
+					break;
+				}
+				if (shared) {
+					lua_pushvalue(L, -2);
+					lua_insert(L, -2);
+					lua_rawset(L, to);
+				}
+				else {
+					lua_pop(L, 1);
+				}
+			}
+			if (lua_getmetatable(L, from) != 0) {
+				lua_setmetatable(L, to);
+			}
+			return to;
+		}
+
+		// Acts on the lookup table entry on top of the stack
+		// Returns -1 if the key is not a member
+		template <bool b>
+		inline int call_found_member(lua_State* L) {
+			switch (type_of(L, -1)) {
+			case type::function:
+				if (b) {
+					return 1;
+				}
+				// functions cannot be assigned to, so there is nothing to set
+				lua_pop(L, 1);
+				return 0;
+			case type::lightuserdata: {
+				variable_entry& v = *static_cast<variable_entry*>(lua_touserdata(L, -1));
+				lua_pop(L, 1);
+				return b ? v.index(L, v.data) : v.new_index(L, v.data);
+			}
+			default:
+				lua_pop(L, 1);
+				return -1;
+			}
+		}
+
+		template <bool b>
+		inline int call_member(lua_State* L, const reference& lookup, int key) {
+			lua_rawgeti(L, LUA_REGISTRYINDEX, lookup.registry_index());
+			lua_pushvalue(L, key);
+			lua_rawget(L, -2);
+			lua_remove(L, -2);
+			return call_found_member<b>(L);
+		}
+
+		// For lookup tables already on the stack, such as upvalues
+		template <bool b>
+		inline int call_member(lua_State* L, int lookup, int key) {
+			lua_pushvalue(L, key);
+			lua_rawget(L, lookup);
+			return call_found_member<b>(L);
+		}
+
+		// Whole number keys on an instance go to the usertype's integer
+		// accessors, before anything looks at the key as a string
+		inline bool is_integer_key(lua_State* L, int key) {
+			if (lua_type(L, key) != LUA_TNUMBER || lua_type(L, 1) != LUA_TUSERDATA) {
+				return false;
+			}
+			int isnum = 0;
+			lua_tointegerx(L, key, &isnum);
+			return isnum != 0;
+		}
+
+		// Fields set on an instance that its usertype does not have are kept in
+		// a table stored as the userdata's user value, which is made on the first
+		// set, so instances that never get one pay nothing. Only reached once the
+		// member lookup and the bases have missed
+		// Returns -1 if the usertype's own __index / __newindex should run instead:
+		// always for sets if it has one, and for gets of fields that were never set
+		template <bool b>
+		inline int dynamic_field(lua_State* L, bool hasfallback) {
+			if (type_of(L, 1) != type::userdata || (!b && hasfallback)) {
+				// the usertype's table itself, or a usertype
+				// that takes care of setting unknown keys itself
+				return -1;
+			}
+			lua_getuservalue(L, 1);
+			bool exists = type_of(L, -1) == type::table;
+			if (b) {
+				if (exists) {
+					lua_pushvalue(L, 2);
+					lua_rawget(L, -2);
+					if (type_of(L, -1) != type::nil) {
+						return 1;
+					}
+					lua_pop(L, 1);
+				}
+				lua_pop(L, 1);
+				if (hasfallback) {
+					return -1;
+				}
+				lua_pushnil(L);
+				return 1;
+			}
+			if (!exists) {
+				lua_pop(L, 1);
+				if (type_of(L, 3) == type::nil) {
+					return 0;
+				}
+				lua_newtable(L);
+				lua_pushvalue(L, -1);
+				lua_setuservalue(L, 1);
+			}
+			lua_pushvalue(L, 2);
+			lua_pushvalue(L, 3);
+			lua_rawset(L, -3);
+			lua_pop(L, 1);
+			return 0;
+		}
+
+		template <bool b, typename Base>
+		inline void walk_single_base(lua_State* L, bool& found, int& ret, string_detail::string_shim&) {
+			if (found)
+				return;
+			const char* gcmetakey = &detail::usertype_names<Base>::gc_table()[0];
+			const void* basewalkkey = b ? detail::base_class_index_propogation_key() : detail::base_class_new_index_propogation_key();
+			
+			if (!detail::get_usertype_metatable<Base>(L)) {
+				lua_pop(L, 1);
+				return;
+			}
+			lua_rawgetp(L, -1, basewalkkey);
+			if (type_of(L, -1) == type::nil) {
+				lua_pop(L, 2);
+				return;
+			}
+			lua_CFunction basewalkfunc = stack::pop<lua_CFunction>(L);
+			lua_pop(L, 1);
+			
+			stack::get_field<true>(L, gcmetakey);
+			int value = basewalkfunc(L);
+			if (value > -1) {
+				found = true;
+				ret = value;
+			}
+		}
+
+		template <bool b, typename... Bases>
+		inline void walk_all_bases(lua_State* L, bool& found, int& ret, string_detail::string_shim& accessor) {
+			(void)L;
+			(void)found;
+			(void)ret;
+			(void)accessor;
+			(void)detail::swallow{ 0, (walk_single_base<b, Bases>(L, found, ret, accessor), 0)... };
+		}
+
 		struct add_destructor_tag {};
 		struct check_destructor_tag {};
 		struct verified_tag {} const verified{};
@@ -138,20 +407,28 @@ namespace sol {
 		typedef std::tuple<clean_type_t<Tn> ...> Tuple;
 		template <std::size_t Idx>
 		struct check_binding : is_variable_binding<meta::unqualified_tuple_element_t<Idx, Tuple>> {};
-		typedef void (*base_walk)(lua_State*, bool&, int&, string_detail::string_shim&);
+		typedef usertype_detail::base_walk base_walk;
 		Tuple functions;
+		reference memberlookup;
+		std::array<usertype_detail::variable_entry, sizeof...(I)> variableentries;
 		lua_CFunction indexfunc;
 		lua_CFunction newindexfunc;
 		lua_CFunction destructfunc;
 		lua_CFunction callconstructfunc;
+		lua_CFunction integerindexfunc;
+		lua_CFunction integernewindexfunc;
 		lua_CFunction indexbase;
 		lua_CFunction newindexbase;
+		usertype_detail::base_flatten baseclassflatten;
 		base_walk indexbaseclasspropogation;
 		base_walk newindexbaseclasspropogation;
-		void* baseclasscheck;
-		void* baseclasscast;
+		const detail::inheritance_table* baseclasstable;
 		bool mustindex;
 		bool secondarymeta;
+		bool dynamicfields;
+#ifdef SOL_BINDING_STATS
+		std::array<detail::binding_record*, sizeof...(I)> bindingrecords;
+#endif // Binding Statistics
 
 		template <std::size_t Idx, meta::enable<std::is_same<lua_CFunction, meta::unqualified_tuple_element<Idx + 1, RawTuple>>> = meta::enabler>
 		inline lua_CFunction make_func() {
@@ -196,15 +473,34 @@ namespace sol {
 			mustindex = true;
 			(void)detail::swallow{ 0, ((detail::has_derived<Bases>::value = true), 0)... };
 
-			static_assert(sizeof(void*) <= sizeof(detail::inheritance_check_function), "The size of this data pointer is too small to fit the inheritance checking function: file a bug report.");
-			static_assert(sizeof(void*) <= sizeof(detail::inheritance_cast_function), "The size of this data pointer is too small to fit the inheritance checking function: file a bug report.");
-			baseclasscheck = (void*)&detail::inheritance<T, Bases...>::type_check;
-			baseclasscast = (void*)&detail::inheritance<T, Bases...>::type_cast;
-			indexbaseclasspropogation = walk_all_bases<true, Bases...>;
-			newindexbaseclasspropogation = walk_all_bases<false, Bases...>;
+			baseclasstable = &detail::inheritance<T, Bases...>::table();
+			indexbaseclasspropogation = usertype_detail::walk_all_bases<true, Bases...>;
+			newindexbaseclasspropogation = usertype_detail::walk_all_bases<false, Bases...>;
+			baseclassflatten = usertype_detail::flatten_bases<Bases...>;
+		}
+
+		template <std::size_t Idx, typename F>
+		void make_regs(regs_t&, int&, integer_index_tag, F&&) {
+			integerindexfunc = call<Idx + 1>;
+			mustindex = true;
+		}
+
+		template <std::size_t Idx, typename F>
+		void make_regs(regs_t&, int&, integer_new_index_tag, F&&) {
+			integernewindexfunc = call<Idx + 1, false>;
+			mustindex = true;
+		}
+
+		template <std::size_t>
+		void make_regs(regs_t&, int&, dynamic_fields_tag, bool enabled) {
+			if (!enabled) {
+				return;
+			}
+			dynamicfields = true;
+			mustindex = true;
 		}
 
-		template <std::size_t Idx, typename N, typename F, typename = std::enable_if_t<!meta::any_same<meta::unqualified_t<N>, base_classes_tag, call_construction>::value>>
+		template <std::size_t Idx, typename N, typename F, typename = std::enable_if_t<!meta::any_same<meta::unqualified_t<N>, base_classes_tag, call_construction, dynamic_fields_tag, integer_index_tag, integer_new_index_tag>::value>>
 		void make_regs(regs_t& l, int& index, N&& n, F&&) {
 			if (is_variable_binding<meta::unqualified_t<F>>::value) {
 				return;
@@ -234,97 +530,125 @@ namespace sol {
 		template <typename... Args, typename = std::enable_if_t<sizeof...(Args) == sizeof...(Tn)>>
 		usertype_metatable(Args&&... args) : functions(std::forward<Args>(args)...),
 		indexfunc(usertype_detail::indexing_fail<true>), newindexfunc(usertype_detail::indexing_fail<false>),
-		destructfunc(nullptr), callconstructfunc(nullptr), 
+		destructfunc(nullptr), callconstructfunc(nullptr), integerindexfunc(nullptr), integernewindexfunc(nullptr),
 		indexbase(&core_indexing_call<true>), newindexbase(&core_indexing_call<false>),
-		indexbaseclasspropogation(walk_all_bases<true>), newindexbaseclasspropogation(walk_all_bases<false>),
-		baseclasscheck(nullptr), baseclasscast(nullptr), 
-		mustindex(contains_variable() || contains_index()), secondarymeta(contains_variable()) {
+		baseclassflatten(usertype_detail::flatten_bases<>),
+		indexbaseclasspropogation(usertype_detail::walk_all_bases<true>), newindexbaseclasspropogation(usertype_detail::walk_all_bases<false>),
+		baseclasstable(nullptr), 
+		mustindex(contains_variable() || contains_index()), secondarymeta(contains_variable()), dynamicfields(false) {
+#ifdef SOL_BINDING_STATS
+			bindingrecords.fill(nullptr);
+#endif // Binding Statistics
+		}
+
+#ifdef SOL_BINDING_STATS
+		template <std::size_t Idx, typename N>
+		void register_binding(lua_State* L, N&& n) {
+			string_detail::string_shim name = usertype_detail::make_shim(std::forward<N>(n));
+			// destructors can run during lua_close, after the records are gone
+			if (name == name_of(meta_function::garbage_collect)) {
+				return;
+			}
+			bindingrecords[Idx / 2] = detail::register_binding(L, detail::usertype_names<T>::name() + "." + std::string(name.data(), name.size()));
 		}
 
-		template <std::size_t I0, std::size_t I1, bool is_index>
-		int real_find_call(std::integral_constant<bool, is_index>, lua_State* L) {
-			if (is_variable_binding<decltype(std::get<I1>(functions))>::value) {
-				return real_call_with<I1, is_index, true>(L, *this);
-			}
-			return stack::push(L, c_closure(call<I1, is_index>, stack::push(L, light<usertype_metatable>(*this))));
+		template <std::size_t Idx>
+		void register_binding(lua_State*, base_classes_tag) {}
+
+		template <std::size_t Idx>
+		void register_binding(lua_State*, dynamic_fields_tag) {}
+
+		void register_bindings(lua_State* L) {
+			(void)detail::swallow{ 0, (register_binding<(I * 2)>(L, std::get<(I * 2)>(functions)), 0)... };
 		}
+#endif // Binding Statistics
 
-		template <std::size_t I0, std::size_t I1, bool is_index>
-		void find_call(std::integral_constant<bool, is_index> idx, lua_State* L, bool& found, int& ret, const sol::string_detail::string_shim& accessor) {
-			if (found) {
-				return;
-			}
-			string_detail::string_shim name = usertype_detail::make_shim(std::get<I0>(functions));
-			if (accessor != name) {
-				return;
-			}
-			found = true;
-			ret = real_find_call<I0, I1>(idx, L);
+		template <std::size_t Idx, bool is_index>
+		static int variable_call(lua_State* L, void* um) {
+			return real_call_with<Idx + 1, is_index, true>(L, *static_cast<usertype_metatable*>(um));
 		}
 
-		template <bool b>
-		void propogating_call(lua_State* L, bool& found, int& ret, string_detail::string_shim& accessor) {
-			(void)detail::swallow{ 0, (find_call<I * 2, I * 2 + 1>(std::integral_constant<bool, b>(), L, found, ret, accessor), 0)... };
+		template <std::size_t Idx>
+		void push_lookup_entry(lua_State* L, std::true_type) {
+			usertype_detail::variable_entry& v = variableentries[Idx / 2];
+			v.data = static_cast<void*>(this);
+			v.index = &variable_call<Idx, true>;
+			v.new_index = &variable_call<Idx, false>;
+			lua_pushlightuserdata(L, static_cast<void*>(&v));
 		}
 
-		template <bool b, typename Base>
-		static void walk_single_base(lua_State* L, bool& found, int& ret, string_detail::string_shim&) {
-			if (found)
-				return;
-			const char* metakey = &usertype_traits<Base>::metatable[0];
-			const char* gcmetakey = &usertype_traits<Base>::gc_table[0];
-			const char* basewalkkey = b ? detail::base_class_index_propogation_key() : detail::base_class_new_index_propogation_key();
-			
-			luaL_getmetatable(L, metakey);
-			if (type_of(L, -1) == type::nil) {
-				lua_pop(L, 1);
-				return;
-			}
-			stack::get_field(L, basewalkkey);
-			if (type_of(L, -1) == type::nil) {
-				lua_pop(L, 2);
-				return;
-			}
-			lua_CFunction basewalkfunc = stack::pop<lua_CFunction>(L);
+		template <std::size_t Idx>
+		void push_lookup_entry(lua_State* L, std::false_type) {
+			detail::count_hot_path(L, &hot_path_counters::index_closures);
+			stack::push(L, c_closure(make_func<Idx>(), stack::push(L, light<usertype_metatable>(*this))));
+		}
+
+		template <std::size_t Idx, typename N>
+		void add_member_lookup(lua_State* L, int lookup, N&& n) {
+			push_lookup_entry<Idx>(L, check_binding<Idx + 1>());
+			usertype_detail::add_member_lookup(L, lookup, usertype_detail::make_shim(std::forward<N>(n)));
+		}
+
+		template <std::size_t Idx>
+		void add_member_lookup(lua_State*, int, base_classes_tag) {}
+
+		template <std::size_t Idx>
+		void add_member_lookup(lua_State*, int, dynamic_fields_tag) {}
+
+		template <std::size_t Idx>
+		void add_member_lookup(lua_State*, int, integer_index_tag) {}
+
+		template <std::size_t Idx>
+		void add_member_lookup(lua_State*, int, integer_new_index_tag) {}
+
+		void make_member_lookup(lua_State* L) {
+			lua_createtable(L, 0, static_cast<int>(sizeof...(I)));
+			int lookup = lua_gettop(L);
+			(void)detail::swallow{ 0, (add_member_lookup<(I * 2)>(L, lookup, std::get<(I * 2)>(functions)), 0)... };
+			baseclassflatten(L, lookup);
+			memberlookup = reference(L, lookup);
 			lua_pop(L, 1);
-			
-			stack::get_field<true>(L, gcmetakey);
-			int value = basewalkfunc(L);
-			if (value > -1) {
-				found = true;
-				ret = value;
-			}
 		}
 
-		template <bool b, typename... Bases>
-		static void walk_all_bases(lua_State* L, bool& found, int& ret, string_detail::string_shim& accessor) {
-			(void)L;
-			(void)found;
-			(void)ret;
-			(void)accessor;
-			(void)detail::swallow{ 0, (walk_single_base<b, Bases>(L, found, ret, accessor), 0)... };
+		template <bool b>
+		int fallback(lua_State* L) {
+			lua_CFunction f = b ? indexfunc : newindexfunc;
+			if (dynamicfields) {
+				int ret = usertype_detail::dynamic_field<b>(L, f != &usertype_detail::indexing_fail<b>);
+				if (ret > -1) {
+					return ret;
+				}
+			}
+			return f(L);
 		}
 
 		template <bool b, bool toplevel = false>
 		static int core_indexing_call(lua_State* L) {
 			usertype_metatable& f = toplevel ? stack::get<light<usertype_metatable>>(L, upvalue_index(1)) : stack::pop<light<usertype_metatable>>(L);
 			static const int keyidx = -2 + static_cast<int>(b);
-			if (toplevel && stack::get<type>(L, keyidx) != type::string) {
-				return b ? f.indexfunc(L) : f.newindexfunc(L);
+			if (toplevel) {
+				lua_CFunction integeraccess = b ? f.integerindexfunc : f.integernewindexfunc;
+				if (integeraccess != nullptr && usertype_detail::is_integer_key(L, keyidx)) {
+					return integeraccess(L);
+				}
+				if (stack::get<type>(L, keyidx) != type::string) {
+					return f.fallback<b>(L);
+				}
 			}
-			string_detail::string_shim accessor = stack::get<string_detail::string_shim>(L, keyidx);
-			int ret = 0;
-			bool found = false;
-			f.propogating_call<b>(L, found, ret, accessor);
-			if (found) {
+			int ret = usertype_detail::call_member<b>(L, f.memberlookup, lua_absindex(L, keyidx));
+			if (ret > -1) {
 				return ret;
 			}
-			// Otherwise, we need to do propagating calls through the bases
-			f.indexbaseclasspropogation(L, found, ret, accessor);
+			// Otherwise, the base may have been registered after us:
+			// we need to do propagating calls through the bases
+			string_detail::string_shim accessor = stack::get<string_detail::string_shim>(L, keyidx);
+			bool found = false;
+			usertype_detail::base_walk walkbaseclasses = b ? f.indexbaseclasspropogation : f.newindexbaseclasspropogation;
+			walkbaseclasses(L, found, ret, accessor);
 			if (found) {
 				return ret;
 			}
-			return toplevel ? (b ? f.indexfunc(L) : f.newindexfunc(L)) : -1;
+			return toplevel ? f.fallback<b>(L) : -1;
 		}
 
 		static int real_index_call(lua_State* L) {
@@ -344,6 +668,9 @@ namespace sol {
 		template <std::size_t Idx, bool is_index = true, bool is_variable = false>
 		static int real_call_with(lua_State* L, usertype_metatable& um) {
 			auto& f = std::get<Idx>(um.functions);
+#ifdef SOL_BINDING_STATS
+			detail::binding_scope scope(um.bindingrecords[Idx / 2]);
+#endif // Binding Statistics
 			return call_detail::call_wrapped<T, is_index, is_variable>(L, f);
 		}
 
@@ -386,7 +713,7 @@ namespace sol {
 				// otherwise all the light userdata we make later will become invalid
 
 				// Create the top level thing that will act as our deleter later on
-				const char* gcmetakey = &usertype_traits<T>::gc_table[0];
+				const char* gcmetakey = &detail::usertype_names<T>::gc_table()[0];
 				stack::push<user<umt_t>>(L, std::move(umx));
 				stack_reference umt(L, -1);
 				stack::set_field<true>(L, gcmetakey, umt);
@@ -397,92 +724,78 @@ namespace sol {
 			}
 
 			static int push(lua_State* L, umt_t&& umx) {
+				detail::heap_origin_scope origin(L, "sol: usertype registration");
 				
 				umt_t& um = make_cleanup(L, std::move(umx));
+#ifdef SOL_BINDING_STATS
+				um.register_bindings(L);
+#endif // Binding Statistics
 				regs_t value_table{ {} };
 				int lastreg = 0;
 				(void)detail::swallow{ 0, (um.template make_regs<(I * 2)>(value_table, lastreg, std::get<(I * 2)>(um.functions), std::get<(I * 2 + 1)>(um.functions)), 0)... };
+				um.make_member_lookup(L);
 				um.finish_regs(value_table, lastreg);
 				value_table[lastreg] = { nullptr, nullptr };
-				bool hasdestructor = !value_table.empty() && name_of(meta_function::garbage_collect) == value_table[lastreg - 1].name;
-				regs_t ref_table = value_table;
-				regs_t unique_table = value_table;
-				if (hasdestructor) {
-					ref_table[lastreg - 1] = { nullptr, nullptr };
-					unique_table[lastreg - 1] = { value_table[lastreg - 1].name, detail::unique_destruct<T> };
-				}
+				bool hasdestructor = lastreg > 0 && name_of(meta_function::garbage_collect) == value_table[lastreg - 1].name;
 				
 				// Now use um
 				const bool& mustindex = um.mustindex;
-				for (std::size_t i = 0; i < 3; ++i) {
-					// Pointer types, AKA "references" from C++
-					const char* metakey = nullptr;
-					luaL_Reg* metaregs = nullptr;
-					switch (i) {
-					case 0:
-						metakey = &usertype_traits<T*>::metatable[0];
-						metaregs = ref_table.data();
-						break;
-					case 1:
-						metakey = &usertype_traits<detail::unique_usertype<T>>::metatable[0];
-						metaregs = unique_table.data();
-						break;
-					case 2:
-					default:
-						metakey = &usertype_traits<T>::metatable[0];
-						metaregs = value_table.data();
-						break;
-					}
-					luaL_newmetatable(L, metakey);
-					stack_reference t(L, -1);
-					stack::push(L, make_light(um));
-					luaL_setfuncs(L, metaregs, 1);
-					
-					if (um.baseclasscheck != nullptr) {
-						stack::set_field(L, detail::base_class_check_key(), um.baseclasscheck, t.stack_index());
-					}
-					else {
-						stack::set_field(L, detail::base_class_check_key(), nil, t.stack_index());
-					}
-					if (um.baseclasscast != nullptr) {
-						stack::set_field(L, detail::base_class_cast_key(), um.baseclasscast, t.stack_index());
-					}
-					else {
-						stack::set_field(L, detail::base_class_cast_key(), nil, t.stack_index());
-					}
-					
-					stack::set_field(L, detail::base_class_index_propogation_key(), make_closure(um.indexbase, make_light(um)), t.stack_index());
-					stack::set_field(L, detail::base_class_new_index_propogation_key(), make_closure(um.newindexbase, make_light(um)), t.stack_index());
-
-					if (mustindex) {
-						// Basic index pushing: specialize
-						// index and newindex to give variables and stuff
-						stack::set_field(L, meta_function::index, make_closure(umt_t::index_call, make_light(um)), t.stack_index());
-						stack::set_field(L, meta_function::new_index, make_closure(umt_t::new_index_call, make_light(um)), t.stack_index());
-					}
-					else {
-						// If there's only functions, we can use the fast index version
-						stack::set_field(L, meta_function::index, t, t.stack_index());
-					}
-					// metatable on the metatable
-					// for call constructor purposes and such
-					lua_createtable(L, 0, 1);
-					stack_reference metabehind(L, -1);
-					if (um.callconstructfunc != nullptr) {
-						stack::set_field(L, meta_function::call_function, make_closure(um.callconstructfunc, make_light(um)), metabehind.stack_index());
-					}
-					if (um.secondarymeta) {
-						stack::set_field(L, meta_function::index, make_closure(umt_t::index_call, make_light(um)), metabehind.stack_index());
-						stack::set_field(L, meta_function::new_index, make_closure(umt_t::new_index_call, make_light(um)), metabehind.stack_index());
-					}
-					stack::set_field(L, metatable_key, metabehind, t.stack_index());
-					metabehind.pop();
-					// We want to just leave the table
-					// in the registry only, otherwise we return it
-					if (i < 2) {
-						t.pop();
-					}
+				// The value metatable is also the usertype's table in Lua,
+				// so it is the one that holds every function
+				detail::count_hot_path(L, &hot_path_counters::new_metatables);
+				luaL_newmetatable(L, &detail::usertype_names<T>::metatable()[0]);
+				stack_reference t(L, -1);
+				stack::push(L, make_light(um));
+				luaL_setfuncs(L, value_table.data(), 1);
+				
+				if (um.baseclasstable != nullptr) {
+					lua_pushlightuserdata(L, const_cast<detail::inheritance_table*>(um.baseclasstable));
+				}
+				else {
+					lua_pushnil(L);
+				}
+				lua_rawsetp(L, t.stack_index(), detail::base_class_table_key());
+				
+				stack::push(L, um.memberlookup);
+				lua_rawsetp(L, t.stack_index(), detail::base_class_member_lookup_key());
+				stack::push(L, make_closure(um.indexbase, make_light(um)));
+				lua_rawsetp(L, t.stack_index(), detail::base_class_index_propogation_key());
+				stack::push(L, make_closure(um.newindexbase, make_light(um)));
+				lua_rawsetp(L, t.stack_index(), detail::base_class_new_index_propogation_key());
+
+				if (mustindex) {
+					// Basic index pushing: specialize
+					// index and newindex to give variables and stuff
+					stack::set_field(L, meta_function::index, make_closure(umt_t::index_call, make_light(um)), t.stack_index());
+					stack::set_field(L, meta_function::new_index, make_closure(umt_t::new_index_call, make_light(um)), t.stack_index());
+				}
+				else {
+					// If there's only functions, we can use the fast index version
+					stack::set_field(L, meta_function::index, t, t.stack_index());
+				}
+				// metatable on the metatable
+				// for call constructor purposes and such
+				lua_createtable(L, 0, 1);
+				stack_reference metabehind(L, -1);
+				if (um.callconstructfunc != nullptr) {
+					stack::set_field(L, meta_function::call_function, make_closure(um.callconstructfunc, make_light(um)), metabehind.stack_index());
 				}
+				if (um.secondarymeta) {
+					stack::set_field(L, meta_function::index, make_closure(umt_t::index_call, make_light(um)), metabehind.stack_index());
+					stack::set_field(L, meta_function::new_index, make_closure(umt_t::new_index_call, make_light(um)), metabehind.stack_index());
+				}
+				stack::set_field(L, metatable_key, metabehind, t.stack_index());
+				metabehind.pop();
+
+				// Pointer types, AKA "references" from C++, and unique usertypes
+				// index through the value metatable instead of repeating its functions
+				usertype_detail::new_shared_metatable<T*>(L, t.stack_index());
+				lua_pop(L, 1);
+				int unique = usertype_detail::new_shared_metatable<detail::unique_usertype<T>>(L, t.stack_index());
+				if (hasdestructor) {
+					stack::set_field<false, true>(L, meta_function::garbage_collect, detail::unique_destruct<T>, unique);
+				}
+				lua_pop(L, 1);
 				
 				return 1;
 			}
@@ -26,29 +26,88 @@
 
 namespace sol {
 
+	// Names are built on first use rather than during static initialization,
+	// so usertypes can be registered from other static constructors
 	template<typename T>
 	struct usertype_traits {
-		static const std::string name;
-		static const std::string qualified_name;
-		static const std::string metatable;
-		static const std::string user_gc_metatable;
-		static const std::string gc_table;
+		static const std::string& get_name() {
+			static const std::string n = detail::short_demangle<T>();
+			return n;
+		}
+		static const std::string& get_qualified_name() {
+			static const std::string q_n = detail::demangle<T>();
+			return q_n;
+		}
+		static const std::string& get_metatable() {
+			static const std::string m = std::string("sol.").append(detail::demangle<T>());
+			return m;
+		}
+		static const std::string& get_user_gc_metatable() {
+			static const std::string u_g_m = std::string("sol.").append(detail::demangle<T>()).append(".user\xE2\x99\xBB");
+			return u_g_m;
+		}
+		static const std::string& get_gc_table() {
+			static const std::string g_t = std::string("sol.").append(detail::demangle<T>()).append(".\xE2\x99\xBB");
+			return g_t;
+		}
+
+		// Aliases of the above, for code that reads the names as data members:
+		// reading one of these during static initialization is still unordered
+		static const std::string& name;
+		static const std::string& qualified_name;
+		static const std::string& metatable;
+		static const std::string& user_gc_metatable;
+		static const std::string& gc_table;
 	};
 
 	template<typename T>
-	const std::string usertype_traits<T>::name = detail::short_demangle<T>();
+	const std::string& usertype_traits<T>::name = usertype_traits<T>::get_name();
 
 	template<typename T>
-	const std::string usertype_traits<T>::qualified_name = detail::demangle<T>();
+	const std::string& usertype_traits<T>::qualified_name = usertype_traits<T>::get_qualified_name();
 
 	template<typename T>
-	const std::string usertype_traits<T>::metatable = std::string("sol.").append(detail::demangle<T>());
+	const std::string& usertype_traits<T>::metatable = usertype_traits<T>::get_metatable();
 
 	template<typename T>
-	const std::string usertype_traits<T>::user_gc_metatable = std::string("sol.").append(detail::demangle<T>()).append(".user\xE2\x99\xBB");
+	const std::string& usertype_traits<T>::user_gc_metatable = usertype_traits<T>::get_user_gc_metatable();
 
 	template<typename T>
-	const std::string usertype_traits<T>::gc_table = std::string("sol.").append(detail::demangle<T>().append(".\xE2\x99\xBB"));
+	const std::string& usertype_traits<T>::gc_table = usertype_traits<T>::get_gc_table();
+
+	namespace detail {
+		// Sol reads the names through here: a specialization of usertype_traits
+		// written before the get_ functions existed only has the data members
+		template <typename Tr>
+		inline auto traits_name(int) -> decltype(Tr::get_name()) { return Tr::get_name(); }
+		template <typename Tr>
+		inline const std::string& traits_name(long) { return Tr::name; }
+		template <typename Tr>
+		inline auto traits_qualified_name(int) -> decltype(Tr::get_qualified_name()) { return Tr::get_qualified_name(); }
+		template <typename Tr>
+		inline const std::string& traits_qualified_name(long) { return Tr::qualified_name; }
+		template <typename Tr>
+		inline auto traits_metatable(int) -> decltype(Tr::get_metatable()) { return Tr::get_metatable(); }
+		template <typename Tr>
+		inline const std::string& traits_metatable(long) { return Tr::metatable; }
+		template <typename Tr>
+		inline auto traits_user_gc_metatable(int) -> decltype(Tr::get_user_gc_metatable()) { return Tr::get_user_gc_metatable(); }
+		template <typename Tr>
+		inline const std::string& traits_user_gc_metatable(long) { return Tr::user_gc_metatable; }
+		template <typename Tr>
+		inline auto traits_gc_table(int) -> decltype(Tr::get_gc_table()) { return Tr::get_gc_table(); }
+		template <typename Tr>
+		inline const std::string& traits_gc_table(long) { return Tr::gc_table; }
+
+		template <typename T>
+		struct usertype_names {
+			static const std::string& name() { return traits_name<usertype_traits<T>>(0); }
+			static const std::string& qualified_name() { return traits_qualified_name<usertype_traits<T>>(0); }
+			static const std::string& metatable() { return traits_metatable<usertype_traits<T>>(0); }
+			static const std::string& user_gc_metatable() { return traits_user_gc_metatable<usertype_traits<T>>(0); }
+			static const std::string& gc_table() { return traits_gc_table<usertype_traits<T>>(0); }
+		};
+	} // detail
 
 }
 
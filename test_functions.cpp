@@ -3,6 +3,7 @@
 #include <catch.hpp>
 #include <sol.hpp>
 #include <iostream>
+#include <memory>
 #include "test_stack_guard.hpp"
 
 std::function<int()> makefn() {
@@ -883,3 +884,28 @@ TEST_CASE("overloading/c_call", "Make sure that overloading works with c_call fu
 	REQUIRE(r4 == 32);
 	REQUIRE(r5 == 1);
 }
+
+TEST_CASE("functions/stateful-destruction", "each stateful function destroys its own captured state when it is collected") {
+	std::shared_ptr<int> first = std::make_shared<int>(1);
+	std::shared_ptr<int> second = std::make_shared<int>(2);
+	// same closure type for both, so both share one gc metatable
+	auto make = [](std::shared_ptr<int> p) {
+		return [p]() { return *p; };
+	};
+	{
+		sol::state lua;
+		lua.open_libraries(sol::lib::base);
+		lua.set_function("f", make(first));
+		lua.set_function("g", make(second));
+		REQUIRE(first.use_count() == 2);
+		REQUIRE(second.use_count() == 2);
+
+		lua.script("g = nil collectgarbage() collectgarbage()");
+		REQUIRE(first.use_count() == 2);
+		REQUIRE(second.use_count() == 1);
+
+		int r = lua["f"]();
+		REQUIRE(r == 1);
+	}
+	REQUIRE(first.use_count() == 1);
+}
@@ -237,3 +237,62 @@ g2 = test.global2
 	REQUIRE(g == 10);
 	REQUIRE(g2 == 25);
 }
+
+TEST_CASE("usertypes/simple-variables", "with variable_fields, simple usertype variables and properties use field syntax on values, pointers and unique usertypes") {
+	struct point {
+		int x = 1;
+		int y = 2;
+
+		int sum() const {
+			return x + y;
+		}
+
+		int get_y() const {
+			return y;
+		}
+
+		void set_y(int v) {
+			y = v;
+		}
+	};
+
+	sol::state lua;
+	lua.new_simple_usertype<point>("point",
+		"x", &point::x,
+		"y", sol::property(&point::get_y, &point::set_y),
+		"total", sol::property(&point::sum),
+		"sum", &point::sum,
+		sol::variable_fields, true
+		);
+
+	point p;
+	lua["v"] = point();
+	lua["p"] = &p;
+	lua["u"] = std::make_shared<point>();
+
+	lua.script(R"(
+v.x = 10
+v.y = 20
+p.x = 3
+u.y = 7
+vsum = v:sum()
+vtotal = v.total
+px = p.x
+uy = u.y
+)");
+	int vsum = lua["vsum"];
+	int vtotal = lua["vtotal"];
+	int px = lua["px"];
+	int uy = lua["uy"];
+	REQUIRE(vsum == 30);
+	REQUIRE(vtotal == 30);
+	REQUIRE(px == 3);
+	REQUIRE(p.x == 3);
+	REQUIRE(uy == 7);
+
+	lua.script("missing = v.nothing_here");
+	sol::object missing = lua["missing"];
+	REQUIRE(missing.get_type() == sol::type::nil);
+	REQUIRE_THROWS(lua.script("v.nothing_here = 5"));
+	REQUIRE_THROWS(lua.script("v.total = 5"));
+}
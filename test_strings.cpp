@@ -92,3 +92,18 @@ TEST_CASE("detail/demangling", "test some basic demangling cases") {
 	REQUIRE(nsteststr == "ns_test");
 	REQUIRE(nsateststr == "ns_anon_test");
 }
+
+TEST_CASE("detail/meta-function-names", "meta function names round trip through the stack, and unknown names fall back to construct") {
+	sol::state lua;
+	for (std::size_t i = 0; i < sol::meta_function_names.size(); ++i) {
+		sol::meta_function mf = static_cast<sol::meta_function>(i);
+		sol::stack::push(lua, sol::name_of(mf));
+		sol::meta_function got = sol::stack::pop<sol::meta_function>(lua);
+		REQUIRE(got == mf);
+	}
+	sol::stack::push(lua, "__nope");
+	sol::meta_function unknown = sol::stack::pop<sol::meta_function>(lua);
+	REQUIRE(unknown == sol::meta_function::construct);
+	REQUIRE(sol::usertype_traits<muh_namespace::ns_test>::get_name() == "ns_test");
+	REQUIRE(&sol::usertype_traits<muh_namespace::ns_test>::name == &sol::usertype_traits<muh_namespace::ns_test>::get_name());
+}
@@ -4,6 +4,8 @@
 #include <sol.hpp>
 #include <iostream>
 #include <map>
+#include <list>
+#include <set>
 #include <algorithm>
 #include <numeric>
 #include <iterator>
@@ -573,3 +575,121 @@ TEST_CASE("tables/returns", "make sure that even references to vectors are being
 	matching = t[3] == 3;
 	REQUIRE(matching);
 }
+
+TEST_CASE("tables/as-container", "containers pushed with as_container are worked on in place, not copied") {
+	struct point {
+		int x;
+	};
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<point>("point", "x", &point::x);
+
+	std::vector<int> v{ 1, 2, 3 };
+	std::map<std::string, int> m{ { "a", 1 }, { "b", 2 } };
+	std::vector<point> points{ { 1 }, { 2 } };
+	lua["v"] = sol::as_container(v);
+	lua["m"] = sol::as_container(m);
+	lua["points"] = sol::as_container(points);
+	lua["owned"] = sol::as_container(std::vector<int>{ 10, 20 });
+
+	lua.script(R"(
+v[1] = 11
+v[4] = 4
+v:add(5)
+v:insert(1, 0)
+v:erase(2)
+len = v:size()
+sum = 0
+for i, x in v:pairs() do
+	sum = sum + x
+end
+m.a = 100
+m.c = 3
+m.b = nil
+points[2].x = 20
+owned:add(30)
+owned_len = owned:size()
+)");
+	REQUIRE((v == std::vector<int>{ 0, 2, 3, 4, 5 }));
+	int len = lua["len"];
+	REQUIRE(len == 5);
+	int sum = lua["sum"];
+	REQUIRE(sum == 14);
+	REQUIRE((m == std::map<std::string, int>{ { "a", 100 }, { "c", 3 } }));
+	REQUIRE(points[1].x == 20);
+	int owned_len = lua["owned_len"];
+	REQUIRE(owned_len == 3);
+
+	std::vector<int>& same = lua["v"].get<std::vector<int>&>();
+	REQUIRE(&same == &v);
+	std::vector<int>& owned = lua["owned"].get<std::vector<int>&>();
+	REQUIRE((owned == std::vector<int>{ 10, 20, 30 }));
+
+	REQUIRE_THROWS(lua.script("v[10] = 1"));
+	REQUIRE_THROWS(lua.script("v.add(1)"));
+}
+
+TEST_CASE("tables/as-container-metatables", "containers pushed with as_container keep their own metatable, whatever was pushed before them") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+
+	std::vector<int> v{ 1, 2, 3 };
+	lua["p"] = &v;
+	lua["c"] = sol::as_container(v);
+	lua.new_usertype<std::vector<int>>("int_vector", "count", [](std::vector<int>& self) { return self.size(); });
+	lua["owned"] = sol::as_container(std::vector<int>{ 4, 5 });
+	lua["u"] = &v;
+
+	lua.script(R"(
+x = c[2]
+c[3] = 30
+n = #owned
+k = u:count()
+)");
+	int x = lua["x"];
+	REQUIRE(x == 2);
+	REQUIRE(v[2] == 30);
+	int n = lua["n"];
+	REQUIRE(n == 2);
+	int k = lua["k"];
+	REQUIRE(k == 3);
+	std::vector<int>& same = lua["c"].get<std::vector<int>&>();
+	REQUIRE(&same == &v);
+}
+
+TEST_CASE("tables/as-container-sequential", "containers without random access are walked by pairs and not indexed by position") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+
+	std::list<int> l{ 1, 2, 3 };
+	std::set<int> s{ 5, 7 };
+	lua["l"] = sol::as_container(l);
+	lua["s"] = sol::as_container(s);
+
+	lua.script(R"(
+l:add(4)
+l[5] = 5
+sum, last = 0, 0
+for i, x in pairs(l) do
+	sum = sum + x
+	last = i
+end
+ssum = 0
+for _, x in s:pairs() do
+	ssum = ssum + x
+end
+len = #l
+)");
+	REQUIRE((l == std::list<int>{ 1, 2, 3, 4, 5 }));
+	int sum = lua["sum"];
+	REQUIRE(sum == 15);
+	int last = lua["last"];
+	REQUIRE(last == 5);
+	int ssum = lua["ssum"];
+	REQUIRE(ssum == 12);
+	int len = lua["len"];
+	REQUIRE(len == 5);
+	REQUIRE_THROWS(lua.script("local x = l[1]"));
+	REQUIRE_THROWS(lua.script("l[1] = 0"));
+}
@@ -1393,3 +1393,572 @@ TEST_CASE("usertype/inheritance", "test that metatables are properly inherited")
 	REQUIRE(b == 10);
 	REQUIRE(a == 5);
 }
+
+TEST_CASE("usertype/erased", "type-erased usertypes support the same bindings as regular ones") {
+	struct bark {
+		int var = 50;
+
+		void fun() {
+			var = 51;
+		}
+
+		int get() const {
+			return var;
+		}
+
+		int set(int x) {
+			var = x;
+			return var;
+		}
+	};
+
+	sol::state lua;
+	lua.new_erased_usertype<bark>("bark",
+		sol::call_constructor, sol::constructors<sol::types<>>(),
+		"fun", &bark::fun,
+		"get", &bark::get,
+		"set", &bark::set,
+		"var", &bark::var,
+		"x", sol::property(&bark::get),
+		"z", sol::property(&bark::get, &bark::set)
+		);
+
+	lua.script("b = bark()");
+	bark& b = lua["b"];
+	REQUIRE(b.var == 50);
+
+	lua.script("b:fun()");
+	REQUIRE(b.var == 51);
+
+	lua.script("b.var = 20");
+	lua.script("v = b.var");
+	int v = lua["v"];
+	REQUIRE(v == 20);
+
+	lua.script("b:set(24)");
+	lua.script("x = b.x");
+	int x = lua["x"];
+	REQUIRE(x == 24);
+
+	lua.script("b.z = 30");
+	lua.script("z = b:get()");
+	int z = lua["z"];
+	REQUIRE(z == 30);
+
+	REQUIRE_THROWS(lua.script("b.nope = 1"));
+}
+
+TEST_CASE("usertype/erased-inheritance", "type-erased usertypes walk regular and erased bases alike") {
+	struct A {
+		int a = 5;
+	};
+
+	struct B {
+		int b() {
+			return 10;
+		}
+	};
+
+	struct C : B, A {
+		double c = 2.4;
+	};
+
+	struct D : C {
+		bool d() const {
+			return true;
+		}
+	};
+
+	sol::state lua;
+	lua.new_usertype<A>("A",
+		"a", &A::a
+		);
+	lua.new_erased_usertype<B>("B",
+		"b", &B::b
+		);
+	lua.new_erased_usertype<C>("C",
+		"c", &C::c,
+		sol::base_classes, sol::bases<B, A>()
+		);
+	lua.new_usertype<D>("D",
+		"d", &D::d,
+		sol::base_classes, sol::bases<C, B, A>()
+		);
+
+	lua.script("obj = D.new()");
+	lua.script("d = obj:d()");
+	bool d = lua["d"];
+	lua.script("c = obj.c");
+	double c = lua["c"];
+	lua.script("b = obj:b()");
+	int b = lua["b"];
+	lua.script("a = obj.a");
+	int a = lua["a"];
+
+	REQUIRE(d);
+	REQUIRE(c == 2.4);
+	REQUIRE(b == 10);
+	REQUIRE(a == 5);
+}
+
+TEST_CASE("usertype/member-lookup", "members are found by name no matter where they were registered") {
+	struct many {
+		int v0 = 0, v1 = 1, v2 = 2, v3 = 3, v4 = 4, v5 = 5, v6 = 6, v7 = 7;
+
+		int f0() const {
+			return 10;
+		}
+
+		int f1() const {
+			return 11;
+		}
+	};
+
+	sol::state lua;
+	lua.new_usertype<many>("many",
+		"v0", &many::v0, "v1", &many::v1, "v2", &many::v2, "v3", &many::v3,
+		"f0", &many::f0,
+		"v4", &many::v4, "v5", &many::v5, "v6", &many::v6, "v7", &many::v7,
+		"f1", &many::f1
+		);
+
+	lua.script("m = many.new()");
+	lua.script("x = m.v0 + m.v7 + m:f0() + m:f1()");
+	lua.script("m.v5 = 50");
+	int x = lua["x"];
+	many& m = lua["m"];
+	REQUIRE(x == 28);
+	REQUIRE(m.v5 == 50);
+	REQUIRE_THROWS(lua.script("y = m.v8"));
+	REQUIRE_THROWS(lua.script("m[1] = 2"));
+}
+
+TEST_CASE("usertype/method-closures-reused", "looking up a method on a usertype with variables returns the same closure every time") {
+	struct mixed {
+		int value = 24;
+
+		int get() const {
+			return value;
+		}
+	};
+
+	struct mixed_derived : mixed {};
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<mixed>("mixed",
+		"get", &mixed::get,
+		"value", &mixed::value
+		);
+	lua.new_usertype<mixed_derived>("mixed_derived",
+		sol::base_classes, sol::bases<mixed>()
+		);
+
+	lua.script("m = mixed.new()");
+	lua.script("d = mixed_derived.new()");
+	lua.script("same = rawequal(m.get, m.get)");
+	lua.script("shared = rawequal(m.get, d.get)");
+	lua.script("x = d:get()");
+	bool same = lua["same"];
+	bool shared = lua["shared"];
+	int x = lua["x"];
+	REQUIRE(same);
+	REQUIRE(shared);
+	REQUIRE(x == 24);
+}
+
+TEST_CASE("usertype/inheritance-registration-order", "inherited members are found whether the bases are registered before or after the derived type") {
+	struct A {
+		int a = 5;
+
+		int get_a() const {
+			return a;
+		}
+	};
+
+	struct B : A {
+		int b = 10;
+	};
+
+	struct C : B {
+		int c = 15;
+	};
+
+	sol::state lua;
+	lua.new_usertype<C>("C",
+		"c", &C::c,
+		sol::base_classes, sol::bases<B, A>()
+		);
+	lua.new_usertype<A>("A",
+		"a", &A::a,
+		"get_a", &A::get_a
+		);
+	lua.new_usertype<B>("B",
+		"b", &B::b,
+		sol::base_classes, sol::bases<A>()
+		);
+
+	lua.script("obj = C.new()");
+	lua.script("obj.a = 6");
+	lua.script("x = obj.a + obj.b + obj.c + obj:get_a()");
+	int x = lua["x"];
+	REQUIRE(x == 37);
+
+	lua.script("bobj = B.new()");
+	lua.script("bobj.a = 7");
+	lua.script("y = bobj.a + bobj:get_a()");
+	int y = lua["y"];
+	REQUIRE(y == 14);
+}
+
+TEST_CASE("usertype/inheritance-reregistered-base", "members flattened from a base keep working after the base is registered again and collected") {
+	struct A {
+		int a = 5;
+
+		int get_a() const {
+			return a;
+		}
+	};
+
+	struct B : A {
+		int b = 10;
+	};
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<A>("A",
+		"a", &A::a,
+		"get_a", &A::get_a
+		);
+	lua.new_usertype<B>("B",
+		"b", &B::b,
+		sol::base_classes, sol::bases<A>()
+		);
+	lua.new_usertype<A>("A",
+		"a", &A::a
+		);
+	lua.script("collectgarbage() collectgarbage()");
+
+	lua.script("obj = B.new() obj.a = 6 x = obj.a + obj.b + obj:get_a()");
+	int x = lua["x"];
+	REQUIRE(x == 22);
+}
+
+TEST_CASE("usertype/inheritance-casts", "derived-to-base conversions adjust pointers for multiple inheritance and reject unrelated types") {
+	struct left {
+		int l = 1;
+		virtual ~left() {}
+	};
+
+	struct right {
+		int r = 2;
+		virtual ~right() {}
+	};
+
+	struct both : left, right {
+		int b = 3;
+	};
+
+	struct other : left {
+		int o = 4;
+	};
+
+	sol::state lua;
+	lua.new_usertype<left>("left", "l", &left::l);
+	lua.new_usertype<right>("right", "r", &right::r);
+	lua.new_usertype<both>("both",
+		"b", &both::b,
+		sol::base_classes, sol::bases<left, right>()
+		);
+	lua.new_usertype<other>("other",
+		"o", &other::o,
+		sol::base_classes, sol::bases<left>()
+		);
+	lua.set_function("read_right", [](right& r) { return r.r; });
+	lua.set_function("read_left", [](left* l) { return l->l; });
+
+	both x;
+	x.l = 10;
+	x.r = 20;
+	other y;
+	lua["x"] = &x;
+	lua["y"] = &y;
+
+	lua.script("xr = read_right(x)");
+	lua.script("xl = read_left(x)");
+	lua.script("yl = read_left(y)");
+	int xr = lua["xr"];
+	int xl = lua["xl"];
+	int yl = lua["yl"];
+	REQUIRE(xr == 20);
+	REQUIRE(xl == 10);
+	REQUIRE(yl == 1);
+	REQUIRE_THROWS(lua.script("read_right(y)"));
+}
+
+TEST_CASE("usertype/internal-keys", "sol's bookkeeping in a usertype metatable never takes a string key") {
+	struct base_t {
+		int value = 5;
+	};
+
+	struct derived_t : base_t {
+		int bark() { return value * 2; }
+	};
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::string);
+	lua.new_usertype<base_t>("base_t", "value", &base_t::value);
+	lua.new_usertype<derived_t>("derived_t",
+		"bark", &derived_t::bark,
+		sol::base_classes, sol::bases<base_t>()
+		);
+	lua["d"] = derived_t();
+
+	lua.script(R"(
+strays = 0
+for k, v in pairs(getmetatable(d)) do
+	if type(k) == "string" and k:sub(1, 2) ~= "__" and k ~= "bark" and k ~= "new" then
+		strays = strays + 1
+	end
+end
+)");
+	int strays = lua["strays"];
+	REQUIRE(strays == 0);
+	lua.script("assert(d:bark() == 10)");
+	lua.script("assert(d.value == 5)");
+}
+
+TEST_CASE("usertype/metatable-cache", "cached metatables belong to one state and survive registering the type after it was first pushed") {
+	struct cached_t {
+		int value = 7;
+		int get() const { return value; }
+	};
+
+	sol::state first;
+	sol::state second;
+	first["early"] = cached_t();
+	first.new_usertype<cached_t>("cached_t", "get", &cached_t::get);
+	second.new_usertype<cached_t>("cached_t", "get", &cached_t::get, "value", &cached_t::value);
+	first["late"] = cached_t();
+	second["late"] = cached_t();
+
+	first.script("e = early:get()");
+	first.script("l = late:get()");
+	second.script("v = late.value");
+	int e = first["e"];
+	int l = first["l"];
+	int v = second["v"];
+	REQUIRE(e == 7);
+	REQUIRE(l == 7);
+	REQUIRE(v == 7);
+	cached_t& fromfirst = first["late"];
+	cached_t& fromsecond = second["late"];
+	REQUIRE(fromfirst.value == 7);
+	REQUIRE(fromsecond.value == 7);
+}
+
+TEST_CASE("usertype/shared-metatables", "pointer and unique metatables share the value metatable's functions instead of copying them") {
+	struct shared_t {
+		int value = 3;
+		int get() const { return value; }
+	};
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<shared_t>("shared_t",
+		"get", &shared_t::get,
+		sol::meta_function::to_string, [](const shared_t& s) { return std::to_string(s.value); }
+		);
+
+	shared_t s;
+	lua["v"] = shared_t();
+	lua["p"] = &s;
+	lua["u"] = std::make_shared<shared_t>();
+
+	lua.script(R"(
+local vm, pm, um = getmetatable(v), getmetatable(p), getmetatable(u)
+assert(vm ~= pm and vm ~= um and pm ~= um)
+assert(rawget(pm, "get") == nil and rawget(um, "get") == nil)
+assert(pm.__index == vm.__index and um.__index == vm.__index)
+assert(pm.__tostring == vm.__tostring and um.__tostring == vm.__tostring)
+assert(rawget(pm, "__gc") == nil)
+assert(um.__gc ~= nil and um.__gc ~= vm.__gc)
+results = { v:get(), p:get(), u:get(), tostring(p) }
+)");
+	sol::table results = lua["results"];
+	int vget = results[1];
+	int pget = results[2];
+	int uget = results[3];
+	std::string pstring = results[4];
+	REQUIRE(vget == 3);
+	REQUIRE(pget == 3);
+	REQUIRE(uget == 3);
+	REQUIRE(pstring == "3");
+}
+
+TEST_CASE("usertype/lazy", "lazy usertypes are built on first use from Lua or C++, and their stand-in keeps working") {
+	struct lazy_t {
+		int value = 2;
+		int get() const { return value; }
+	};
+	struct lazy_other_t {
+		int value = 4;
+		int get() const { return value; }
+	};
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_lazy_usertype<lazy_t>("lazy_t", "get", &lazy_t::get, "value", &lazy_t::value);
+	lua.new_lazy_usertype<lazy_other_t>("lazy_other_t", "get", &lazy_other_t::get);
+	REQUIRE(lua_gettop(lua) == 0);
+	lua.script("stand_in = lazy_t");
+	lua.script("x = lazy_t.new()");
+	lua.script("assert(lazy_t ~= stand_in)");
+	lua.script("y = stand_in.new()");
+	lua.script("assert(x:get() == 2 and y.value == 2)");
+	lua.script("assert(getmetatable(x) == getmetatable(y))");
+
+	lua["o"] = lazy_other_t();
+	lua["p"] = std::make_shared<lazy_other_t>();
+	lua.script("assert(o:get() == 4 and p:get() == 4)");
+	lua.script("z = lazy_other_t.new()");
+	lua.script("assert(getmetatable(z) == getmetatable(o))");
+	lazy_other_t& o = lua["o"];
+	REQUIRE(o.value == 4);
+	REQUIRE(lua_gettop(lua) == 0);
+}
+
+TEST_CASE("usertype/dynamic-fields", "instances of usertypes with dynamic fields keep their own extra fields, after every registered member") {
+	struct npc {
+		int health = 10;
+		int get() const { return health; }
+	};
+	struct erased_npc {
+		int health = 20;
+	};
+	struct simple_npc {
+		int health = 30;
+	};
+	struct fixed_npc {
+		int health = 40;
+	};
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<npc>("npc", "health", &npc::health, "get", &npc::get, sol::dynamic_fields, true);
+	lua.new_erased_usertype<erased_npc>("erased_npc", "health", &erased_npc::health, sol::dynamic_fields, true);
+	lua.new_simple_usertype<simple_npc>("simple_npc", "health", &simple_npc::health, sol::variable_fields, true, sol::dynamic_fields, true);
+	lua.new_usertype<fixed_npc>("fixed_npc", "health", &fixed_npc::health);
+
+	lua.script(R"(
+for _, T in ipairs({ npc, erased_npc, simple_npc }) do
+	local a, b = T.new(), T.new()
+	assert(a.ai_state == nil)
+	a.ai_state = "idle"
+	a[1] = "first"
+	a.health = a.health + 1
+	assert(a.ai_state == "idle" and a[1] == "first")
+	assert(b.ai_state == nil and b[1] == nil)
+	a.ai_state = nil
+	assert(a.ai_state == nil)
+end
+local n = npc.new()
+n.tag = "guard"
+assert(n:get() == 10 and n.tag == "guard")
+)");
+	REQUIRE_THROWS(lua.script("fixed_npc.new().ai_state = 1"));
+	lua.script("guard = npc.new() guard.health = 12 guard.extra = true");
+	npc& guard = lua["guard"];
+	REQUIRE(guard.health == 12);
+}
+
+TEST_CASE("usertype/integer-index", "whole number keys go to the integer accessors of every kind of usertype, and other keys do not") {
+	struct buffer {
+		std::vector<int> data = std::vector<int>(4, 1);
+		int get(std::size_t i) const { return data[i - 1]; }
+		void set(std::size_t i, int v) { data[i - 1] = v; }
+		std::size_t size() const { return data.size(); }
+	};
+	struct erased_buffer : buffer {};
+	struct simple_buffer : buffer {};
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<buffer>("buffer",
+		sol::integer_index, [](buffer& b, std::size_t i) { return b.get(i); },
+		sol::integer_new_index, [](buffer& b, std::size_t i, int v) { b.set(i, v); },
+		sol::meta_function::length, [](buffer& b) { return b.size(); },
+		"size", [](buffer& b) { return b.size(); }
+		);
+	lua.new_erased_usertype<erased_buffer>("erased_buffer",
+		sol::integer_index, [](erased_buffer& b, std::size_t i) { return b.get(i); },
+		sol::integer_new_index, [](erased_buffer& b, std::size_t i, int v) { b.set(i, v); },
+		sol::meta_function::length, [](erased_buffer& b) { return b.size(); },
+		"size", [](erased_buffer& b) { return b.size(); }
+		);
+	lua.new_simple_usertype<simple_buffer>("simple_buffer",
+		sol::integer_index, [](simple_buffer& b, std::size_t i) { return b.get(i); },
+		sol::integer_new_index, [](simple_buffer& b, std::size_t i, int v) { b.set(i, v); },
+		sol::meta_function::length, [](simple_buffer& b) { return b.size(); },
+		"size", [](simple_buffer& b) { return b.size(); }
+		);
+
+	lua.script(R"(
+for _, T in ipairs({ buffer, erased_buffer, simple_buffer }) do
+	local b = T.new()
+	for i = 1, #b do
+		b[i] = b[i] * (i + 1)
+	end
+	assert(b[1] == 2 and b[4] == 5)
+	assert(b:size() == 4)
+end
+)");
+	buffer b;
+	lua["b"] = &b;
+	lua.script("b[2] = 7");
+	REQUIRE(b.data[1] == 7);
+	REQUIRE_THROWS(lua.script("local x = b.nope"));
+}
+
+struct old_traits_type {
+	int value = 24;
+};
+
+namespace sol {
+	template <>
+	struct usertype_traits<old_traits_type> {
+		static const std::string name;
+		static const std::string qualified_name;
+		static const std::string metatable;
+		static const std::string user_gc_metatable;
+		static const std::string gc_table;
+	};
+
+	const std::string usertype_traits<old_traits_type>::name = "old_traits_type";
+	const std::string usertype_traits<old_traits_type>::qualified_name = "old_traits_type";
+	const std::string usertype_traits<old_traits_type>::metatable = "old_traits.meta";
+	const std::string usertype_traits<old_traits_type>::user_gc_metatable = "old_traits.meta.user";
+	const std::string usertype_traits<old_traits_type>::gc_table = "old_traits.gc";
+}
+
+TEST_CASE("usertype/traits-data-members", "specializations of usertype_traits that only provide the data members still name the metatables") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<old_traits_type>("old_traits_type",
+		"value", &old_traits_type::value
+		);
+	lua.script("x = old_traits_type.new() v = x.value");
+	REQUIRE(lua["v"].get<int>() == 24);
+	old_traits_type& x = lua["x"];
+	REQUIRE(x.value == 24);
+
+	lua_State* L = lua.lua_state();
+	lua_getglobal(L, "x");
+	REQUIRE(lua_getmetatable(L, -1) == 1);
+	luaL_getmetatable(L, "old_traits.meta");
+	REQUIRE(lua_rawequal(L, -1, -2) == 1);
+	lua_pop(L, 3);
+	lua_getglobal(L, "old_traits.gc");
+	REQUIRE(lua_type(L, -1) == LUA_TUSERDATA);
+	lua_pop(L, 1);
+}
@@ -560,3 +560,456 @@ TEST_CASE("optional/left-out-args", "Make sure arguments can be left out of opti
         )");
 	);
 }
+
+TEST_CASE("state/binding-stats", "binding statistics are collected per registered name when SOL_BINDING_STATS is on, and are empty otherwise") {
+	struct counted {
+		int value = 0;
+		int get() const {
+			return value;
+		}
+	};
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<counted>("counted",
+		"get", &counted::get,
+		"value", &counted::value
+	);
+	lua.set_function("add", [](int a, int b) { return a + b; });
+	lua["binding_stats"] = sol::lua_binding_stats;
+
+	lua.script(R"(
+c = counted.new()
+c.value = 2
+for i = 1, 3 do
+	x = add(i, c:get())
+end
+ok = pcall(add, "not a number", 1)
+stats = binding_stats()
+)");
+	bool ok = lua["ok"];
+	REQUIRE_FALSE(ok);
+
+	sol::binding_stats_table stats = lua.binding_stats();
+	sol::table luastats = lua["stats"];
+#ifdef SOL_BINDING_STATS
+	const std::string name = sol::usertype_traits<counted>::name;
+	REQUIRE(stats["add"].calls == 4);
+	REQUIRE(stats["add"].argument_failures == 1);
+	REQUIRE(stats["add"].max_time <= stats["add"].total_time);
+	REQUIRE(stats[name + ".get"].calls == 3);
+	REQUIRE(stats[name + ".get"].argument_failures == 0);
+	REQUIRE(stats[name + ".value"].calls == 1);
+	int luacalls = luastats["add"]["calls"];
+	REQUIRE(luacalls == 4);
+
+	lua.reset_binding_stats();
+	stats = lua.binding_stats();
+	REQUIRE(stats["add"].calls == 0);
+	lua.script("add(1, 2)");
+	stats = lua.binding_stats();
+	REQUIRE(stats["add"].calls == 1);
+#else
+	REQUIRE(stats.empty());
+	REQUIRE(luastats.empty());
+#endif // Binding Statistics
+}
+
+TEST_CASE("state/binding-stats-errors", "a binding that raises an error still closes its statistics scope") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.set_function("fail", []() {
+		throw std::runtime_error("failed on purpose");
+	});
+	// not a sol binding, so nothing but a stale record could be charged for its argument error
+	lua_pushcfunction(lua, [](lua_State* L) {
+		return sol::type_panic(L, 1, sol::type::number, sol::type_of(L, 1));
+	});
+	lua_setglobal(lua, "stray");
+
+	lua.script(R"(
+failed = pcall(fail)
+strayed = pcall(stray, "not a number")
+)");
+	bool failed = lua["failed"];
+	bool strayed = lua["strayed"];
+	REQUIRE_FALSE(failed);
+	REQUIRE_FALSE(strayed);
+
+	sol::binding_stats_table stats = lua.binding_stats();
+#ifdef SOL_BINDING_STATS
+	REQUIRE(stats["fail"].calls == 1);
+	REQUIRE(stats["fail"].argument_failures == 0);
+	REQUIRE(stats["fail"].max_time.count() > 0);
+	REQUIRE(stats["fail"].total_time == stats["fail"].max_time);
+#else
+	REQUIRE(stats.empty());
+#endif // Binding Statistics
+}
+
+TEST_CASE("state/accounting-allocator", "the accounting allocator splits memory by category and usertype, and enforces its budget") {
+	struct tracked {
+		double values[4];
+	};
+
+	sol::accounting_allocator allocator;
+	{
+		sol::state lua(allocator);
+		lua.open_libraries(sol::lib::base);
+		REQUIRE(sol::accounting_allocator::from(lua) == &allocator);
+		lua.new_usertype<tracked>("tracked");
+		lua.script(R"(
+objects = {}
+for i = 1, 100 do
+	objects[i] = tracked.new()
+end
+)");
+		sol::memory_stats stats = allocator.stats();
+		const sol::memory_usage& usertype = stats.usertypes[sol::usertype_traits<tracked>::metatable];
+		REQUIRE(usertype.allocations == 100);
+		REQUIRE(usertype.live_bytes >= 100 * sizeof(tracked));
+		REQUIRE(stats.userdata.live_bytes >= usertype.live_bytes);
+		REQUIRE(stats.tables.live_bytes > 0);
+		REQUIRE(stats.total.peak_bytes >= stats.total.live_bytes);
+		std::size_t sum = stats.tables.live_bytes + stats.strings.live_bytes + stats.functions.live_bytes
+			+ stats.userdata.live_bytes + stats.threads.live_bytes + stats.other.live_bytes;
+		REQUIRE(sum == stats.total.live_bytes);
+
+		lua.script("objects = nil collectgarbage() collectgarbage()");
+		stats = allocator.stats();
+		REQUIRE(stats.usertypes[sol::usertype_traits<tracked>::metatable].live_bytes == 0);
+
+		allocator.set_budget(allocator.live_bytes() + 4096);
+		lua.script(R"(
+ok = pcall(function ()
+	local t = {}
+	for i = 1, 100000 do
+		t[i] = i
+	end
+end)
+)");
+		bool ok = lua["ok"];
+		REQUIRE_FALSE(ok);
+		REQUIRE(allocator.stats().failed_allocations > 0);
+		REQUIRE(allocator.live_bytes() <= allocator.budget());
+		allocator.set_budget(0);
+	}
+	REQUIRE(allocator.live_bytes() == 0);
+}
+
+TEST_CASE("state/hot-path-counters", "hot path counters are kept per state when SOL_HOT_PATH_COUNTERS is on, and stay at zero otherwise") {
+	struct counted {
+		int value = 0;
+		int get() const {
+			return value;
+		}
+	};
+
+	sol::state lua;
+	lua.new_usertype<counted>("counted",
+		"get", &counted::get,
+		"value", &counted::value
+	);
+	lua["c"] = counted();
+	lua.script("function loop (n) for i = 1, n do c:get() end end");
+	sol::function loop = lua["loop"];
+
+	sol::hot_path_counters before = lua.hot_path_snapshot();
+	loop(10);
+	sol::hot_path_counters after = lua.hot_path_snapshot();
+	sol::hot_path_counters diff = after - before;
+	{
+		sol::object copied = loop;
+		lua["copy"] = counted();
+	}
+	sol::hot_path_counters more = lua.hot_path_snapshot() - after;
+#ifdef SOL_HOT_PATH_COUNTERS
+	// method closures are made once, at registration, even with variables bound
+	REQUIRE(diff.index_closures == 0);
+	REQUIRE(diff.new_userdata == 0);
+	REQUIRE(diff.peak_stack > 0);
+	REQUIRE(more.refs >= 1);
+	REQUIRE(more.unrefs >= 1);
+	REQUIRE(more.new_userdata == 1);
+	// the metatable was cached by the first push of a counted
+	REQUIRE(more.new_metatables == 0);
+
+	lua.reset_hot_path_counters();
+	REQUIRE(lua.hot_path_snapshot().index_closures == 0);
+#else
+	REQUIRE(diff.index_closures == 0);
+	REQUIRE(more.refs == 0);
+	REQUIRE(after.peak_stack == 0);
+#endif // Hot Path Counters
+}
+
+TEST_CASE("state/profiler", "the sampling profiler charges time to Lua stacks, named after the bindings on them") {
+	sol::state lua;
+	lua.set_function("each", [](int n, sol::function f) {
+		for (int i = 0; i < n; ++i) {
+			f(1000);
+		}
+	});
+	lua.script(R"(
+function spin (n)
+	local x = 0
+	for i = 1, n do
+		x = x + i
+	end
+	return x
+end
+
+function work ()
+	local alias = each
+	for i = 1, 5 do
+		alias(10, spin)
+		spin(10000)
+	end
+end
+)");
+	sol::profiler profiler(lua, 100);
+	profiler.start();
+	REQUIRE(profiler.is_running());
+	lua.script("work()");
+	profiler.stop();
+	REQUIRE_FALSE(profiler.is_running());
+	REQUIRE(profiler.samples() > 0);
+
+	std::uint64_t eachtime = 0;
+	std::uint64_t spintime = 0;
+	bool callsite = false;
+	for (const auto& kvp : profiler.folded_stacks()) {
+		const std::string& stack = kvp.first;
+		if (stack.find("work (") == std::string::npos) {
+			continue;
+		}
+		// C frames carry the name they were bound under, not the local they were called through
+		callsite = callsite || stack.find("[C] alias") != std::string::npos;
+		if (stack.find("[C] each;") != std::string::npos) {
+			eachtime += kvp.second;
+		}
+		else if (stack.find("spin (") != std::string::npos) {
+			spintime += kvp.second;
+		}
+	}
+	REQUIRE_FALSE(callsite);
+	REQUIRE(eachtime > 0);
+	REQUIRE(spintime > 0);
+	REQUIRE_FALSE(profiler.folded().empty());
+
+	profiler.clear();
+	lua.script("work()");
+	REQUIRE(profiler.samples() == 0);
+}
+
+TEST_CASE("state/memory-footprint", "footprints measure what sol's userdata layouts and registrations cost in a state") {
+	struct packed {
+		int a = 0;
+		int b = 0;
+	};
+
+	sol::usertype_footprint f = sol::measure_usertype_footprint<packed>([](sol::state& lua) {
+		lua.new_usertype<packed>("packed", "a", &packed::a, "b", &packed::b);
+	}, packed());
+	REQUIRE(f.name == sol::usertype_traits<packed>::name);
+	REQUIRE(f.value.requested == sizeof(packed*) + sizeof(packed));
+	REQUIRE(f.pointer.requested == sizeof(packed*));
+	REQUIRE(f.value.measured >= f.value.requested);
+	REQUIRE(f.pointer.measured >= f.pointer.requested);
+	REQUIRE(f.unique.measured >= f.unique.requested);
+	REQUIRE(f.value.measured > f.pointer.measured);
+	REQUIRE(f.registration.total > 0);
+	REQUIRE(f.registration.total <= f.registration.tables + f.registration.functions + f.registration.userdata + f.registration.strings + f.registration.other);
+	const sol::registration_tables& t = f.per_table;
+	REQUIRE(t.value_metatable > 0);
+	REQUIRE(t.pointer_metatable > 0);
+	REQUIRE(t.unique_metatable > 0);
+	REQUIRE(t.metabehind > 0);
+	REQUIRE(t.gc_table > 0);
+	// the members live in the value metatable; the others only share its metamethods
+	REQUIRE(t.value_metatable >= t.pointer_metatable);
+	REQUIRE(t.value_metatable + t.pointer_metatable + t.unique_metatable + t.metabehind <= f.registration.tables + f.registration.other);
+
+	double payload[8] = {};
+	auto fx = [payload]() { return payload[0]; };
+	sol::closure_footprint c = sol::measure_closure_footprint("payload", fx);
+	REQUIRE(c.closure.requested >= sizeof(payload));
+	REQUIRE(c.closure.measured >= c.closure.requested);
+
+	sol::footprint_report report;
+	report.add_usertype<packed>(packed()).add_closure("payload", fx);
+	REQUIRE(report.usertypes().size() == 1);
+	REQUIRE(report.functions().size() == 1);
+	std::string table = report.table();
+	REQUIRE(table.find(sol::usertype_traits<packed>::name) != std::string::npos);
+	REQUIRE(table.find("payload") != std::string::npos);
+	REQUIRE(table.find("metabehind") != std::string::npos);
+}
+
+TEST_CASE("state/call-latency", "call latency histograms are kept per name when SOL_CALL_LATENCY is on, and are empty otherwise") {
+	sol::latency_histogram h;
+	for (int i = 1; i <= 100; ++i) {
+		h.record(std::chrono::nanoseconds(i * 1000));
+	}
+	REQUIRE(h.count() == 100);
+	REQUIRE(h.min() == std::chrono::nanoseconds(1000));
+	REQUIRE(h.max() == std::chrono::nanoseconds(100000));
+	REQUIRE(h.mean() == std::chrono::nanoseconds(50500));
+	// buckets are exact to within 12.5%
+	REQUIRE(h.percentile(0.5) >= std::chrono::nanoseconds(50000));
+	REQUIRE(h.percentile(0.5) <= std::chrono::nanoseconds(56250));
+	REQUIRE(h.percentile(0.99) >= std::chrono::nanoseconds(99000));
+	REQUIRE(h.percentile(1.0) == h.max());
+	std::uint64_t bucketed = 0;
+	for (const auto& b : h.buckets()) {
+		bucketed += b.second;
+	}
+	REQUIRE(bucketed == 100);
+	h.reset();
+	REQUIRE(h.count() == 0);
+	REQUIRE(h.percentile(0.99) == std::chrono::nanoseconds::zero());
+
+	sol::state lua;
+	lua.script(R"(
+function add (a, b)
+	return a + b
+end
+
+function fail ()
+	error("failed")
+end
+)");
+	sol::function add = lua["add"];
+	sol::protected_function padd = lua["add"];
+	sol::protected_function fail = lua["fail"];
+	padd.set_latency_name("protected add");
+	for (int i = 0; i < 10; ++i) {
+		int r = add.call<int>(i, 1);
+		REQUIRE(r == i + 1);
+		int pr = padd.call<int>(i, 2);
+		REQUIRE(pr == i + 2);
+	}
+	sol::protected_function_result failed = fail();
+	REQUIRE_FALSE(failed.valid());
+	lua["call_latencies"] = sol::lua_call_latencies;
+	lua.script("latencies = call_latencies()");
+
+	sol::call_latency_table latencies = lua.call_latencies();
+	sol::table lualatencies = lua["latencies"];
+#ifdef SOL_CALL_LATENCY
+	REQUIRE(latencies["protected add"].count() == 10);
+	std::string addname;
+	std::string failname;
+	for (const auto& kvp : latencies) {
+		if (kvp.first.find(":2") != std::string::npos) {
+			addname = kvp.first;
+		}
+		if (kvp.first.find(":6") != std::string::npos) {
+			failname = kvp.first;
+		}
+	}
+	REQUIRE_FALSE(addname.empty());
+	REQUIRE(latencies[addname].count() == 10);
+	REQUIRE(latencies[failname].count() == 1);
+	REQUIRE(latencies[addname].max() >= latencies[addname].percentile(0.5));
+	int luacount = lualatencies["protected add"]["count"];
+	REQUIRE(luacount == 10);
+
+	lua.reset_call_latencies();
+	latencies = lua.call_latencies();
+	REQUIRE(latencies["protected add"].count() == 0);
+	padd(1, 2);
+	REQUIRE(lua.call_latencies()["protected add"].count() == 1);
+#else
+	REQUIRE(latencies.empty());
+	REQUIRE(lualatencies.empty());
+#endif // Call Latency
+}
+
+TEST_CASE("state/heap-profiler", "the heap profiler charges allocations to script lines, bindings and sol's own allocation points") {
+	struct blob {
+		double values[8];
+	};
+
+	sol::heap_profiler profiler(0);
+	{
+		sol::state lua(profiler);
+		REQUIRE(sol::heap_profiler::from(lua) == &profiler);
+		lua.open_libraries(sol::lib::base);
+		lua.new_usertype<blob>("blob");
+		lua.set_function("make_blob", []() { return blob(); });
+		lua.set_function("make_list", []() { return std::vector<int>{ 1, 2, 3, 4 }; });
+		lua.script("keep = {}\nfor i = 1, 100 do keep[i] = { i, i * 2 } end\nblobs = {}\nfor i = 1, 100 do blobs[i] = make_blob() end\nlist = make_list()");
+
+		// nothing is waiting for a location, so the hook is not armed
+		REQUIRE(lua_gethook(lua) == nullptr);
+
+#ifdef SOL_HEAP_ORIGINS
+		const std::string userdata_origin = "sol: usertype userdata";
+		const std::string container_origin = "sol: container table";
+		const std::string registration_origin = "sol: usertype registration";
+#else
+		const std::string userdata_origin = "script";
+		const std::string container_origin = "script";
+		const std::string registration_origin = "script";
+#endif // Heap Origins
+		auto sites = profiler.live_sites();
+		REQUIRE_FALSE(sites.empty());
+		std::size_t total = 0;
+		bool scripttables = false;
+		bool blobs = false;
+		bool container = false;
+		bool registration = false;
+		for (const auto& site : sites) {
+			total += site.live_bytes;
+			if (site.origin == "script" && site.location.find(":2") != std::string::npos) {
+				scripttables = true;
+			}
+			if (site.origin == userdata_origin && site.function == "make_blob") {
+				REQUIRE(site.location.find(":4") != std::string::npos);
+				REQUIRE(site.live_blocks >= 100);
+				blobs = true;
+			}
+			container = container || (site.origin == container_origin && site.function == "make_list");
+			registration = registration || (site.origin == registration_origin && site.location == "[C++]");
+		}
+		REQUIRE(scripttables);
+		REQUIRE(blobs);
+		REQUIRE(container);
+		REQUIRE(registration);
+		// with every allocation sampled, the sites add up to exactly what is live
+		REQUIRE(total == profiler.live_bytes());
+		REQUIRE_FALSE(profiler.report().empty());
+	}
+	REQUIRE(profiler.live_bytes() == 0);
+	REQUIRE(profiler.live_sites().empty());
+	REQUIRE_FALSE(profiler.all_sites().empty());
+}
+
+TEST_CASE("state/heap-profiler-hooks", "the heap profiler leaves a debug hook it did not install alone") {
+	sol::heap_profiler heap(0);
+	sol::state lua(heap);
+	lua.open_libraries(sol::lib::base);
+
+	sol::profiler profiler(lua, 1);
+	profiler.start();
+	lua_Hook installed = lua_gethook(lua);
+	lua.script("keep = {}\nfor i = 1, 100 do keep[i] = { i } end");
+	REQUIRE(lua_gethook(lua) == installed);
+	REQUIRE(profiler.samples() > 0);
+	profiler.stop();
+
+	bool hidden = false;
+	for (const auto& site : heap.live_sites()) {
+		hidden = hidden || (site.location == "?" && site.origin == "script");
+	}
+	REQUIRE(hidden);
+
+	lua.script("more = {}\nfor i = 1, 100 do more[i] = { i } end");
+	bool placed = false;
+	for (const auto& site : heap.live_sites()) {
+		placed = placed || site.location.find(":2") != std::string::npos;
+	}
+	REQUIRE(placed);
+	REQUIRE(lua_gethook(lua) == nullptr);
+}